@@ -0,0 +1,93 @@
+/**
+ * @brief This module has operations for pinning threads to CPUs, and for finding out which NUMA node
+ * a CPU belongs to.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 1.0
+ *
+ */
+
+#define _GNU_SOURCE
+#include <sched.h>
+#include <dirent.h>
+#include <string.h>
+#include "affinity.h"
+
+#define CPU_PATH_BUF 64
+
+/**
+ * A CPU together with the node it belongs to, used for sorting.
+ */
+typedef struct cpu_node {
+    int cpu;
+    int node;
+} Cpu_node;
+
+/**
+ * Sorts CPUs by node, and by number within a node. Used with qsort.
+ */
+static int compare_cpu(const void *a, const void *b) {
+    const Cpu_node *cpu_a = a;
+    const Cpu_node *cpu_b = b;
+    if (cpu_a->node != cpu_b->node) {
+        return cpu_a->node - cpu_b->node;
+    }
+    return cpu_a->cpu - cpu_b->cpu;
+}
+
+int *affinity_cpus(int *cpu_amount) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    int check = sched_getaffinity(0, sizeof(cpu_set_t), &set);
+    error_handler_value(0, check, NULL, "sched_getaffinity", true);
+
+    Cpu_node *cpu_nodes = malloc(CPU_SETSIZE * sizeof(Cpu_node));
+    error_handler_null(cpu_nodes, NULL, "cpu_nodes couldn't allocate memory", true);
+    *cpu_amount = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+        if (CPU_ISSET(cpu, &set)) {
+            cpu_nodes[*cpu_amount].cpu = cpu;
+            cpu_nodes[*cpu_amount].node = affinity_node_of_cpu(cpu);
+            (*cpu_amount)++;
+        }
+    }
+    qsort(cpu_nodes, *cpu_amount, sizeof(Cpu_node), compare_cpu);
+
+    int *cpus = malloc(*cpu_amount * sizeof(int));
+    error_handler_null(cpus, NULL, "cpus couldn't allocate memory", true);
+    for (int i = 0; i < *cpu_amount; i++) {
+        cpus[i] = cpu_nodes[i].cpu;
+    }
+    free(cpu_nodes);
+    return cpus;
+}
+
+int affinity_node_of_cpu(int cpu) {
+    char path[CPU_PATH_BUF];
+    snprintf(path, CPU_PATH_BUF, "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+        return 0;
+    }
+
+    //the directory of a cpu has a link named node<N> to it's node
+    int node = 0;
+    struct dirent *dir_struct;
+    while ((dir_struct = readdir(dir)) != NULL) {
+        if (strncmp(dir_struct->d_name, "node", 4) == 0 && dir_struct->d_name[4] >= '0'
+            && dir_struct->d_name[4] <= '9') {
+            node = atoi(dir_struct->d_name + 4);
+            break;
+        }
+    }
+    closedir(dir);
+    return node;
+}
+
+bool affinity_pin_thread(int cpu) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) == 0;
+}
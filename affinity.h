@@ -0,0 +1,60 @@
+/**
+ * @defgroup affinity_h affinity
+ *
+ * @brief This module has operations for pinning threads to CPUs, and for finding out which NUMA node
+ * a CPU belongs to.
+ *
+ * The NUMA topology is read from /sys/devices/system/cpu. If it can't be read, every CPU is considered
+ * to be on node 0.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 1.0
+ *
+ * @{
+ */
+
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "error_handler.h"
+
+/**
+ * @brief                Gives the CPUs that the program is allowed to run on, sorted by NUMA node so that
+ *                       the CPUs of one node comes after each other.
+ *
+ *                       NOTE! It's the user's responsibility to deallocate the returned value.
+ *
+ * @param cpu_amount     Pointer to an integer where the amount of CPUs is stored.
+ * @return               Returns a dynamically allocated array of CPU numbers.
+ */
+int *affinity_cpus(int *cpu_amount);
+
+
+/**
+ * @brief                Gives the NUMA node that a CPU belongs to.
+ *
+ * @param cpu            The number of the CPU.
+ * @return               Returns the number of the node, 0 if it couldn't be found.
+ */
+int affinity_node_of_cpu(int cpu);
+
+
+/**
+ * @brief                Pins the calling thread to one CPU.
+ *
+ * @param cpu            The number of the CPU.
+ * @return               True if the thread was pinned.
+ */
+bool affinity_pin_thread(int cpu);
+
+#endif //AFFINITY_H
+
+/**
+ * @}
+ */
@@ -0,0 +1,464 @@
+/**
+ * @brief This datatype writes the state of a scan to a checkpoint file, and continues a scan from one.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 1.0
+ *
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include "checkpoint.h"
+
+#define NODE_START_AMOUNT 64
+
+/**
+ * @brief                  A struct holding a directory node that is written to a checkpoint.
+ *
+ * @elem node              The directory node.
+ * @elem has_task          True if the directory is waiting for it's own task.
+ */
+typedef struct checkpoint_node {
+    Dir_node *node;
+    bool has_task;
+} Checkpoint_node;
+
+static Checkpoint_node *collect_nodes(Task_queue *t_queue, size_t *amount);
+static void add_node(Checkpoint_node **nodes, size_t *amount, size_t *capacity, Dir_node *node, bool has_task);
+static void add_task_nodes(Checkpoint_node **nodes, size_t *amount, size_t *capacity, List *tasks);
+static int compare_nodes(const void *a, const void *b);
+static size_t find_node(const Checkpoint_node *nodes, size_t amount, const Dir_node *node);
+static const char *record_name(const char *names, uint64_t names_length, uint64_t offset, uint64_t length);
+static Mdu_error check_checkpoint(const Checkpoint *checkpoint, const char *data, size_t size);
+
+Checkpoint *create_checkpoint(const char *path, double interval, const char *const *roots, int root_amount,
+                              const Mdu_result *results) {
+    Checkpoint *checkpoint = malloc(sizeof(Checkpoint));
+    error_handler_null(checkpoint, NULL, "checkpoint couldn't allocate memory", true);
+    size_t length = strlen(path);
+    checkpoint->path = malloc(length + 1);
+    checkpoint->temp_path = malloc(length + sizeof(".tmp"));
+    error_handler_null(checkpoint->path, NULL, "checkpoint couldn't allocate memory", true);
+    error_handler_null(checkpoint->temp_path, NULL, "checkpoint couldn't allocate memory", true);
+    memcpy(checkpoint->path, path, length + 1);
+    memcpy(checkpoint->temp_path, path, length);
+    memcpy(&checkpoint->temp_path[length], ".tmp", sizeof(".tmp"));
+    checkpoint->interval = interval > 0 ? interval : 0;
+    clock_gettime(CLOCK_MONOTONIC, &checkpoint->last_time);
+    checkpoint->stopped = false;
+    checkpoint->complete = false;
+    checkpoint->roots = roots;
+    checkpoint->root_amount = root_amount;
+    checkpoint->root_index = 0;
+    checkpoint->results = results;
+    return checkpoint;
+}
+
+bool checkpoint_due(Checkpoint *checkpoint, bool stopped) {
+    if (checkpoint->stopped) {
+        return false;
+    }
+    if (stopped) {
+        return true;
+    }
+    if (checkpoint->interval == 0) {
+        return false;
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double seconds = (double)(now.tv_sec - checkpoint->last_time.tv_sec)
+                     + (double)(now.tv_nsec - checkpoint->last_time.tv_nsec) / 1e9;
+    return seconds >= checkpoint->interval;
+}
+
+void write_checkpoint(Checkpoint *checkpoint, Task_queue *t_queue, bool stopped) {
+    clock_gettime(CLOCK_MONOTONIC, &checkpoint->last_time);
+    checkpoint->stopped = stopped;
+    size_t amount;
+    Checkpoint_node *nodes = collect_nodes(t_queue, &amount);
+    size_t visited_amount = 0;
+    Inode_key *visited = t_queue->visited != NULL ? inode_set_keys(t_queue->visited, &visited_amount) : NULL;
+
+    //a root without waiting directories is complete, and it's result is in the task queue
+    int root_index = checkpoint->root_index;
+    Mdu_result current = { .totals = t_queue->totals, .duration = t_queue->duration,
+                           .permission = t_queue->permission };
+    if (amount == 0 && root_index < checkpoint->root_amount) {
+        root_index++;
+    }
+    //a scan that was stopped after it's last directory was read has nothing left to continue
+    checkpoint->complete = root_index == checkpoint->root_amount;
+
+    FILE *file = fopen(checkpoint->temp_path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "mdu: checkpoint '%s' couldn't be written: %s\n", checkpoint->temp_path, strerror(errno));
+        free(nodes);
+        free(visited);
+        return;
+    }
+    Checkpoint_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.version = CHECKPOINT_VERSION;
+    header.byte_order = CHECKPOINT_BYTE_ORDER;
+    header.permission = t_queue->permission ? 1 : 0;
+    header.root_amount = checkpoint->root_amount;
+    header.root_index = root_index;
+    header.record_amount = amount;
+    header.timestamp = time(NULL);
+    header.visited_amount = visited_amount;
+    for (int i = 0; i < checkpoint->root_amount; i++) {
+        header.names_length += strlen(checkpoint->roots[i]) + 1;
+    }
+    for (size_t i = 0; i < amount; i++) {
+        header.names_length += nodes[i].node->name_length + 1;
+    }
+    fwrite(&header, sizeof(header), 1, file);
+
+    uint64_t name_offset = 0;
+    for (int i = 0; i < checkpoint->root_amount; i++) {
+        Checkpoint_root root;
+        memset(&root, 0, sizeof(root));
+        root.name_offset = name_offset;
+        root.name_length = strlen(checkpoint->roots[i]);
+        if (i < checkpoint->root_index) {
+            root.result = checkpoint->results[i];
+        } else if (i < root_index) {
+            root.result = current;
+        }
+        fwrite(&root, sizeof(root), 1, file);
+        name_offset += root.name_length + 1;
+    }
+    for (size_t i = 0; i < amount; i++) {
+        Dir_node *node = nodes[i].node;
+        Checkpoint_record record;
+        memset(&record, 0, sizeof(record));
+        record.parent = node->parent == NULL ? CHECKPOINT_NO_PARENT : find_node(nodes, i, node->parent) + 1;
+        record.name_offset = name_offset;
+        record.name_length = node->name_length;
+        record.id = node->id;
+        record.depth = node->depth;
+        record.has_task = nodes[i].has_task ? 1 : 0;
+        record.has_stat = node->has_stat ? 1 : 0;
+        record.read_error = node->read_error ? 1 : 0;
+        record.sample_rate = node->sample_rate;
+        record.totals = node->totals;
+        if (node->has_stat) {
+            record.stat = node->stat;
+        }
+        fwrite(&record, sizeof(record), 1, file);
+        name_offset += record.name_length + 1;
+    }
+    for (size_t i = 0; i < visited_amount; i++) {
+        Checkpoint_inode inode = { .dev = visited[i].dev, .ino = visited[i].ino };
+        fwrite(&inode, sizeof(inode), 1, file);
+    }
+    free(visited);
+    for (int i = 0; i < checkpoint->root_amount; i++) {
+        fwrite(checkpoint->roots[i], 1, strlen(checkpoint->roots[i]) + 1, file);
+    }
+    for (size_t i = 0; i < amount; i++) {
+        fwrite(nodes[i].node->name, 1, nodes[i].node->name_length + 1, file);
+    }
+    free(nodes);
+
+    //the checkpoint is on the disk before it replaces the last one
+    bool written = fflush(file) == 0 && !ferror(file) && fsync(fileno(file)) == 0;
+    written = fclose(file) == 0 && written;
+    if (!written || rename(checkpoint->temp_path, checkpoint->path) != 0) {
+        fprintf(stderr, "mdu: checkpoint '%s' couldn't be written: %s\n", checkpoint->path, strerror(errno));
+        remove(checkpoint->temp_path);
+    }
+}
+
+Mdu_error resume_checkpoint(Checkpoint *checkpoint, Task_queue *t_queue, Mdu_result *results,
+                            void (*task_pointer)(struct task *, Worker *), List *tasks, int *root_index) {
+    *root_index = 0;
+    FILE *file = fopen(checkpoint->path, "r");
+    if (file == NULL && errno == ENOENT) {
+        return MDU_ERROR_NONE;
+    }
+    //a checkpoint that can't be resumed is kept, it might be resumed with the right paths
+    checkpoint->stopped = true;
+    if (file == NULL) {
+        return MDU_ERROR_CHECKPOINT;
+    }
+    struct stat buf;
+    if (fstat(fileno(file), &buf) != 0 || (size_t)buf.st_size < sizeof(Checkpoint_header)) {
+        fclose(file);
+        return MDU_ERROR_CHECKPOINT;
+    }
+    size_t size = buf.st_size;
+    char *data = malloc(size);
+    error_handler_null(data, NULL, "checkpoint couldn't allocate memory", true);
+    bool complete = fread(data, 1, size, file) == size;
+    fclose(file);
+    Mdu_error error = complete ? check_checkpoint(checkpoint, data, size) : MDU_ERROR_CHECKPOINT;
+    if (error != MDU_ERROR_NONE) {
+        free(data);
+        return error;
+    }
+    checkpoint->stopped = false;
+
+    const Checkpoint_header *header = (const Checkpoint_header *)data;
+    const Checkpoint_root *roots = (const Checkpoint_root *)(header + 1);
+    const Checkpoint_record *records = (const Checkpoint_record *)(roots + header->root_amount);
+    const Checkpoint_inode *inodes = (const Checkpoint_inode *)(records + header->record_amount);
+    const char *names = (const char *)(inodes + header->visited_amount);
+    *root_index = (int)header->root_index;
+    for (int i = 0; i < *root_index; i++) {
+        results[i] = roots[i].result;
+    }
+
+    //the nodes are created parents first, and every node is pending for it's own task until it's released
+    Dir_node **nodes = malloc((header->record_amount + 1) * sizeof(Dir_node *));
+    error_handler_null(nodes, NULL, "checkpoint couldn't allocate memory", true);
+    long max_id = 0;
+    for (uint64_t i = 0; i < header->record_amount; i++) {
+        const Checkpoint_record *record = &records[i];
+        const char *name = &names[record->name_offset];
+        Dir_node *node = create_dir_node(i == 0 ? NULL : nodes[record->parent - 1], name, record->id);
+        node->has_stat = record->has_stat != 0;
+        if (node->has_stat) {
+            node->stat = record->stat;
+            //the directories of the checkpoint have been reached, if links are followed
+            if (t_queue->visited != NULL) {
+                inode_set_insert(t_queue->visited, node->stat.st_dev, node->stat.st_ino);
+            }
+        }
+        node->read_error = record->read_error != 0;
+        node->sample_rate = record->sample_rate;
+        node->totals = record->totals;
+        if (record->has_task) {
+            list_insert(list_end(tasks), create_task(node, task_pointer));
+        }
+        max_id = record->id > max_id ? record->id : max_id;
+        nodes[i] = node;
+    }
+    //a directory that has been read is only waiting for the directories inside of it
+    for (uint64_t i = 0; i < header->record_amount; i++) {
+        if (!records[i].has_task) {
+            nodes[i]->pending--;
+        }
+    }
+    free(nodes);
+    //a link into a directory that was completed before the checkpoint isn't followed again
+    for (uint64_t i = 0; t_queue->visited != NULL && i < header->visited_amount; i++) {
+        inode_set_insert(t_queue->visited, (dev_t)inodes[i].dev, (ino_t)inodes[i].ino);
+    }
+
+    for (int i = 0; i < t_queue->thread_amount; i++) {
+        Worker *worker = t_queue->workers[i];
+        long dir_amount = max_id / t_queue->thread_amount + 1;
+        worker->dir_amount = worker->dir_amount > dir_amount ? worker->dir_amount : dir_amount;
+    }
+    t_queue->permission = header->permission != 0;
+    clock_gettime(CLOCK_MONOTONIC, &checkpoint->last_time);
+    free(data);
+    return MDU_ERROR_NONE;
+}
+
+void destroy_checkpoint(Checkpoint *checkpoint) {
+    if ((!checkpoint->stopped || checkpoint->complete) && remove(checkpoint->path) != 0 && errno != ENOENT) {
+        fprintf(stderr, "mdu: checkpoint '%s' couldn't be removed: %s\n", checkpoint->path, strerror(errno));
+    }
+    free(checkpoint->path);
+    free(checkpoint->temp_path);
+    free(checkpoint);
+}
+
+/**
+ * @brief                Collects the directory nodes of every waiting task, and the nodes above them. The
+ *                       nodes are sorted by their depth and id, so every node comes after it's parent.
+ *
+ * @param t_queue        The task queue, with the tasks in it's queue and deques.
+ * @param amount         Where the amount of nodes is stored.
+ * @return               The nodes, dynamically allocated.
+ */
+static Checkpoint_node *collect_nodes(Task_queue *t_queue, size_t *amount) {
+    size_t capacity = NODE_START_AMOUNT;
+    Checkpoint_node *nodes = malloc(capacity * sizeof(Checkpoint_node));
+    error_handler_null(nodes, NULL, "checkpoint couldn't allocate memory", true);
+    *amount = 0;
+    add_task_nodes(&nodes, amount, &capacity, t_queue->task_q);
+    for (int i = 0; i < t_queue->thread_amount; i++) {
+        Worker *worker = t_queue->workers[i];
+        pthread_mutex_lock(&worker->mutex);
+        add_task_nodes(&nodes, amount, &capacity, worker->deque);
+        pthread_mutex_unlock(&worker->mutex);
+    }
+    size_t task_amount = *amount;
+    for (size_t i = 0; i < task_amount; i++) {
+        for (Dir_node *parent = nodes[i].node->parent; parent != NULL; parent = parent->parent) {
+            add_node(&nodes, amount, &capacity, parent, false);
+        }
+    }
+    qsort(nodes, *amount, sizeof(Checkpoint_node), compare_nodes);
+
+    //the nodes above several tasks were added once for each of them
+    size_t unique = 0;
+    for (size_t i = 0; i < *amount; i++) {
+        if (unique == 0 || nodes[unique - 1].node != nodes[i].node) {
+            nodes[unique++] = nodes[i];
+        }
+    }
+    *amount = unique;
+    return nodes;
+}
+
+/**
+ * @brief                Adds the nodes of a list of tasks. Kill tasks, without a node, are left out.
+ *
+ * @param nodes          The nodes, which might be reallocated.
+ * @param amount         Amount of nodes.
+ * @param capacity       Amount of nodes there is room for.
+ * @param tasks          The list of tasks.
+ */
+static void add_task_nodes(Checkpoint_node **nodes, size_t *amount, size_t *capacity, List *tasks) {
+    for (ListPos pos = list_first(tasks); !list_pos_equal(pos, list_end(tasks)); pos = list_next(pos)) {
+        Task *task = list_inspect(pos);
+        if (task->node != NULL) {
+            add_node(nodes, amount, capacity, task->node, true);
+        }
+    }
+}
+
+/**
+ * @brief                Adds a node to the nodes of a checkpoint.
+ *
+ * @param nodes          The nodes, which might be reallocated.
+ * @param amount         Amount of nodes.
+ * @param capacity       Amount of nodes there is room for.
+ * @param node           The directory node.
+ * @param has_task       True if the directory is waiting for it's own task.
+ */
+static void add_node(Checkpoint_node **nodes, size_t *amount, size_t *capacity, Dir_node *node, bool has_task) {
+    if (*amount == *capacity) {
+        *capacity *= 2;
+        *nodes = realloc(*nodes, *capacity * sizeof(Checkpoint_node));
+        error_handler_null(*nodes, NULL, "checkpoint couldn't allocate memory", true);
+    }
+    (*nodes)[(*amount)++] = (Checkpoint_node) { .node = node, .has_task = has_task };
+}
+
+/**
+ * @brief                Compares two nodes by their depth, and then by their id, for qsort.
+ *
+ * @param a              The first node.
+ * @param b              The second node.
+ * @return               Less than, equal to or greater than 0, as a comes before, together with or after b.
+ */
+static int compare_nodes(const void *a, const void *b) {
+    const Dir_node *node = ((const Checkpoint_node *)a)->node;
+    const Dir_node *other = ((const Checkpoint_node *)b)->node;
+    if (node->depth != other->depth) {
+        return (node->depth > other->depth) - (node->depth < other->depth);
+    }
+    return (node->id > other->id) - (node->id < other->id);
+}
+
+/**
+ * @brief                Finds a node among nodes sorted by compare_nodes, with a binary search.
+ *
+ * @param nodes          The sorted nodes.
+ * @param amount         Amount of nodes to search among.
+ * @param node           The node, which has to be among them.
+ * @return               The index of the node.
+ */
+static size_t find_node(const Checkpoint_node *nodes, size_t amount, const Dir_node *node) {
+    Checkpoint_node key = { .node = (Dir_node *)node, .has_task = false };
+    size_t low = 0;
+    size_t high = amount;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (compare_nodes(&nodes[middle], &key) < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief                Gives a name from the string table of a checkpoint, if it's inside of the table and null
+ *                       terminated.
+ *
+ * @param names          The string table.
+ * @param names_length   Amount of bytes in the string table.
+ * @param offset         The offset of the name.
+ * @param length         Amount of bytes in the name.
+ * @return               The name. NULL if it isn't a valid name.
+ */
+static const char *record_name(const char *names, uint64_t names_length, uint64_t offset, uint64_t length) {
+    if (offset >= names_length || length >= names_length - offset || names[offset + length] != '\0') {
+        return NULL;
+    }
+    return &names[offset];
+}
+
+/**
+ * @brief                Checks that the contents of a checkpoint file can be resumed, before anything is created
+ *                       from it. The records have to be inside of the file, with their names in the string table,
+ *                       every record has to come after it's parent, and a record without a task has to have
+ *                       records inside of it.
+ *
+ * @param checkpoint     The checkpoints of the scan, with the roots of the scan.
+ * @param data           The contents of the file.
+ * @param size           Amount of bytes in the file, at least the size of the header.
+ * @return               MDU_ERROR_NONE, or the error that the file has.
+ */
+static Mdu_error check_checkpoint(const Checkpoint *checkpoint, const char *data, size_t size) {
+    const Checkpoint_header *header = (const Checkpoint_header *)data;
+    if (memcmp(header->magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0
+        || header->version != CHECKPOINT_VERSION || header->byte_order != CHECKPOINT_BYTE_ORDER
+        || header->root_amount > (size - sizeof(Checkpoint_header)) / sizeof(Checkpoint_root)
+        || header->record_amount > (size - sizeof(Checkpoint_header) - header->root_amount * sizeof(Checkpoint_root))
+                                   / sizeof(Checkpoint_record)
+        || header->visited_amount > (size - sizeof(Checkpoint_header) - header->root_amount * sizeof(Checkpoint_root)
+                                    - header->record_amount * sizeof(Checkpoint_record)) / sizeof(Checkpoint_inode)
+        || header->names_length != size - sizeof(Checkpoint_header) - header->root_amount * sizeof(Checkpoint_root)
+                                   - header->record_amount * sizeof(Checkpoint_record)
+                                   - header->visited_amount * sizeof(Checkpoint_inode)
+        || header->root_index > header->root_amount
+        || (header->root_index == header->root_amount && header->record_amount > 0)) {
+        return MDU_ERROR_CHECKPOINT;
+    }
+    const Checkpoint_root *roots = (const Checkpoint_root *)(header + 1);
+    const Checkpoint_record *records = (const Checkpoint_record *)(roots + header->root_amount);
+    const char *names = (const char *)((const Checkpoint_inode *)(records + header->record_amount)
+                                       + header->visited_amount);
+
+    bool same_roots = header->root_amount == (uint64_t)checkpoint->root_amount;
+    for (uint64_t i = 0; i < header->root_amount; i++) {
+        const char *name = record_name(names, header->names_length, roots[i].name_offset, roots[i].name_length);
+        if (name == NULL) {
+            return MDU_ERROR_CHECKPOINT;
+        }
+        same_roots = same_roots && strcmp(name, checkpoint->roots[i]) == 0;
+    }
+    if (!same_roots) {
+        return MDU_ERROR_CHECKPOINT_ROOTS;
+    }
+
+    //counts the records inside of every record, which come after it
+    uint64_t *children = calloc(header->record_amount + 1, sizeof(uint64_t));
+    error_handler_null(children, NULL, "checkpoint couldn't allocate memory", true);
+    bool valid = true;
+    for (uint64_t i = 0; valid && i < header->record_amount; i++) {
+        const Checkpoint_record *record = &records[i];
+        const char *name = record_name(names, header->names_length, record->name_offset, record->name_length);
+        valid = name != NULL && (i == 0) == (record->parent == CHECKPOINT_NO_PARENT) && record->parent <= i
+                && (i > 0 || strcmp(name, checkpoint->roots[header->root_index]) == 0);
+        if (valid && i > 0) {
+            children[record->parent - 1]++;
+        }
+    }
+    for (uint64_t i = 0; valid && i < header->record_amount; i++) {
+        valid = records[i].has_task || children[i] > 0;
+    }
+    free(children);
+    return valid ? MDU_ERROR_NONE : MDU_ERROR_CHECKPOINT;
+}
@@ -0,0 +1,239 @@
+/**
+ * @defgroup checkpoint_h checkpoint
+ *
+ * @brief This datatype writes the state of a scan to a checkpoint file, and continues a scan from one.
+ *
+ * A checkpoint is written while every thread of the threadpool is paused between two tasks. Then every
+ * directory that isn't complete is either waiting for it's own task, or for the directories inside of it, so
+ * the tasks that are waiting and the nodes above them are the whole state of the scan. The nodes are written
+ * with the totals they have so far, parents before children, and the totals of the roots that are done are
+ * written before them. The file is written next to the checkpoint and renamed over it, so a checkpoint is
+ * never half written.
+ *
+ * When links are followed, the directories that have been reached are written as well, so that a link into a
+ * directory that was completed before the checkpoint isn't followed after it.
+ *
+ * When a scan is continued, the nodes are created again with their totals, and the tasks are added to the
+ * task queue. The directories that were completed before the checkpoint aren't read again. The numbers are in
+ * the byte order of the machine that wrote it, as in a snapshot.
+ *
+ * When a scan is cancelled, or it's deadline passes, one last checkpoint is written before any directory is
+ * skipped, and the file is kept, so the scan can be continued from where it stopped.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 1.0
+ *
+ * @{
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "list.h"
+#include "dir_node.h"
+#include "t_queue.h"
+#include "libmdu.h"
+#include "error_handler.h"
+
+#define CHECKPOINT_MAGIC "MDUCKPT"
+#define CHECKPOINT_VERSION 4
+#define CHECKPOINT_BYTE_ORDER 0x01020304
+#define CHECKPOINT_NO_PARENT 0
+
+/**
+ * @brief                  A struct which is the structure for the header of a checkpoint file.
+ *
+ * @elem magic             CHECKPOINT_MAGIC, null terminated.
+ * @elem version           CHECKPOINT_VERSION.
+ * @elem byte_order        CHECKPOINT_BYTE_ORDER, as written by the machine that wrote the checkpoint.
+ * @elem permission        1 if every directory of the current root could be read so far, otherwise 0.
+ * @elem root_amount       Amount of roots of the scan, the first records of the file.
+ * @elem root_index        The index of the root that was being calculated. The roots before it are done.
+ * @elem record_amount     Amount of directory records, after the roots.
+ * @elem names_length      Amount of bytes in the string table, after the reached directories.
+ * @elem timestamp         When the checkpoint was written, in seconds since the epoch.
+ * @elem visited_amount    Amount of directories that have been reached, after the records. 0 unless links are
+ *                         followed.
+ */
+typedef struct checkpoint_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t permission;
+    uint32_t reserved;
+    uint64_t root_amount;
+    uint64_t root_index;
+    uint64_t record_amount;
+    uint64_t names_length;
+    int64_t timestamp;
+    uint64_t visited_amount;
+} Checkpoint_header;
+
+/**
+ * @brief                  A struct which is the structure for a root in a checkpoint file.
+ *
+ * @elem name_offset       The offset of the path of the root in the string table. The path is null terminated.
+ * @elem name_length       Amount of bytes in the path.
+ * @elem result            The result of the root, if it's before root_index.
+ */
+typedef struct checkpoint_root {
+    uint64_t name_offset;
+    uint64_t name_length;
+    Mdu_result result;
+} Checkpoint_root;
+
+/**
+ * @brief                  A struct which is the structure for a directory that isn't complete in a checkpoint
+ *                         file.
+ *
+ * @elem parent            The index of the parent's record plus one. CHECKPOINT_NO_PARENT for the root.
+ * @elem name_offset       The offset of the name in the string table. The name is null terminated.
+ * @elem name_length       Amount of bytes in the name.
+ * @elem id                The id of the directory node.
+ * @elem depth             How many directories below the root the directory is.
+ * @elem has_task          1 if the directory is waiting for it's own task, 0 if only for directories inside.
+ * @elem has_stat          1 if stat holds the struct stat of the directory.
+ * @elem read_error        1 if the directory couldn't be opened.
+ * @elem sample_rate       The probability that an estimate picked the directory.
+ * @elem totals            The totals of the directory so far.
+ * @elem stat              The struct stat of the directory, if has_stat is 1.
+ */
+typedef struct checkpoint_record {
+    uint64_t parent;
+    uint64_t name_offset;
+    uint64_t name_length;
+    int64_t id;
+    int32_t depth;
+    uint8_t has_task;
+    uint8_t has_stat;
+    uint8_t read_error;
+    uint8_t reserved;
+    double sample_rate;
+    Mdu_totals totals;
+    struct stat stat;
+} Checkpoint_record;
+
+/**
+ * @brief                  A struct which is the structure for a directory that has been reached in a checkpoint
+ *                         file.
+ *
+ * @elem dev               The device number of the directory.
+ * @elem ino               The inode number of the directory.
+ */
+typedef struct checkpoint_inode {
+    uint64_t dev;
+    uint64_t ino;
+} Checkpoint_inode;
+
+/**
+ * @brief                  A struct which is the structure for the checkpoints of a scan.
+ *
+ * @elem path              The path of the checkpoint file.
+ * @elem temp_path         The path that a checkpoint is written to, before it's renamed to path.
+ * @elem interval          Seconds between two checkpoints. 0 if one is only written when the scan is stopped.
+ * @elem last_time         When the last checkpoint was written, or the scan started, from CLOCK_MONOTONIC.
+ * @elem stopped           True when the checkpoint of a stopped scan has been written, or has failed. After that,
+ *                         no more checkpoints are written, and the file is kept when the scan ends.
+ * @elem complete          True if the last checkpoint was written when every root was done, then the file is
+ *                         removed when the scan ends, even if it was stopped.
+ * @elem roots             The paths of the roots of the scan.
+ * @elem root_amount       Amount of roots.
+ * @elem root_index        The index of the root that is being calculated.
+ * @elem results           The results of the roots, which are set for the roots before root_index.
+ */
+typedef struct checkpoint {
+    char *path;
+    char *temp_path;
+    double interval;
+    struct timespec last_time;
+    bool stopped;
+    bool complete;
+    const char *const *roots;
+    int root_amount;
+    int root_index;
+    const Mdu_result *results;
+} Checkpoint;
+
+
+/**
+ * @brief                Creates the checkpoints of a scan, and allocates memory for them. No file is written.
+ *
+ * @param path           The path of the checkpoint file.
+ * @param interval       Seconds between two checkpoints.
+ * @param roots          The paths of the roots of the scan.
+ * @param root_amount    Amount of roots.
+ * @param results        The results of the roots, set as the roots are done.
+ * @return               Returns a checkpoint that has been dynamically allocated.
+ */
+Checkpoint *create_checkpoint(const char *path, double interval, const char *const *roots, int root_amount,
+                              const Mdu_result *results);
+
+
+/**
+ * @brief                Checks if a checkpoint should be written, which is when the interval has passed since the
+ *                       last one, or when the scan has stopped and it's checkpoint hasn't been written.
+ *
+ * @param checkpoint     The checkpoints of the scan.
+ * @param stopped        True if the scan has been cancelled, or it's deadline has passed.
+ * @return               True if a checkpoint should be written.
+ */
+bool checkpoint_due(Checkpoint *checkpoint, bool stopped);
+
+
+/**
+ * @brief                Writes a checkpoint of the current root. Every thread of the task queue has to be
+ *                       paused between two tasks. A checkpoint that can't be written is reported to stderr,
+ *                       and the scan goes on.
+ *
+ *                       If no directory is waiting, the current root is complete, and it's result is taken
+ *                       from the task queue.
+ *
+ * @param checkpoint     The checkpoints of the scan.
+ * @param t_queue        The task queue, with the waiting tasks in it's queue and deques.
+ * @param stopped        True if the scan has stopped, then it's the last checkpoint that is written.
+ */
+void write_checkpoint(Checkpoint *checkpoint, Task_queue *t_queue, bool stopped);
+
+
+/**
+ * @brief                Reads a checkpoint file, if it exists, and creates the directory nodes and tasks of the
+ *                       root that was being calculated again. Nothing is created if the file isn't a checkpoint
+ *                       of the same roots that can be read by this machine, and the file is kept.
+ *
+ *                       The ids of the workers are moved past the ids of the nodes, so that the new nodes don't
+ *                       get the same ids.
+ *
+ * @param checkpoint     The checkpoints of the scan.
+ * @param t_queue        The task queue, with the workers.
+ * @param results        Where the results of the roots that were done are stored.
+ * @param task_pointer   The function that the tasks run.
+ * @param tasks          A list, where the tasks are added.
+ * @param root_index     Where the index of the root to continue with is stored. 0 if there was no checkpoint file.
+ * @return               MDU_ERROR_NONE, or the error that the checkpoint file has.
+ */
+Mdu_error resume_checkpoint(Checkpoint *checkpoint, Task_queue *t_queue, Mdu_result *results,
+                            void (*task_pointer)(struct task *, Worker *), List *tasks, int *root_index);
+
+
+/**
+ * @brief                Deallocates the checkpoints. The checkpoint file is removed, unless the scan was
+ *                       stopped after it was written before every root was done.
+ *
+ * @param checkpoint     The checkpoints that will be deallocated.
+ */
+void destroy_checkpoint(Checkpoint *checkpoint);
+
+#endif //CHECKPOINT_H
+
+/**
+ * @}
+ */
@@ -0,0 +1,63 @@
+#!/bin/sh
+#
+# Stops a scan with a short deadline, and resumes it from it's checkpoint again and again until it's complete. The
+# total of the resumed scan has to be the total of [du], both without and with -L, where the tree has links into
+# directories that are completed before a checkpoint, and a cycle. A checkpoint that can't be resumed, or is of
+# other paths, has to be reported and kept.
+#
+
+mdu=${1:-./mdu}
+dir=$(mktemp -d)
+checkpoint="$dir.checkpoint"
+trap 'rm -rf "$dir" "$checkpoint" "$checkpoint.tmp"' EXIT
+
+for i in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20 21 22 23 24 25 26 27 28 29 30; do
+    for j in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20 21 22 23 24 25 26 27 28 29 30; do
+        mkdir -p "$dir/d$i/e$j"
+        head -c 5000 /dev/zero > "$dir/d$i/e$j/f"
+    done
+    ln -s "../../d1" "$dir/d$i/e1/link"
+done
+ln -s ".." "$dir/d1/cycle"
+
+#resumes the scan until it's complete, and prints the total
+resume() {
+    rm -f "$checkpoint"
+    stops=0
+    while [ $stops -lt 1000 ]; do
+        resume_flag=
+        [ -f "$checkpoint" ] && resume_flag=--resume
+        total=$("$mdu" "$@" --checkpoint="$checkpoint" --checkpoint-interval=0 --deadline=0.001 $resume_flag \
+                "$dir" 2> /dev/null | cut -f 1)
+        [ -f "$checkpoint" ] || break
+        stops=$((stops + 1))
+    done
+    echo "$total"
+}
+
+status=0
+for flag in -P -L; do
+    expected=$(du -s -B 512 "$flag" "$dir" 2> /dev/null | cut -f 1)
+    for threads in 1 4; do
+        total=$(resume "$flag" -j "$threads")
+        if [ "$total" != "$expected" ]; then
+            echo "checkpoint_test: mdu $flag -j $threads gives $total blocks when resumed, du gives $expected"
+            status=1
+        fi
+    done
+done
+
+"$mdu" --checkpoint="$checkpoint" --checkpoint-interval=0 --deadline=0.000001 "$dir" > /dev/null 2>&1
+if "$mdu" --checkpoint="$checkpoint" --resume "$dir/d1" 2>&1 | grep -q "is a checkpoint of other paths"; then
+    [ -f "$checkpoint" ] || { echo "checkpoint_test: a checkpoint of other paths is removed"; status=1; }
+else
+    echo "checkpoint_test: a checkpoint of other paths isn't reported"
+    status=1
+fi
+head -c 100 /dev/zero > "$checkpoint"
+if "$mdu" --checkpoint="$checkpoint" --resume "$dir" > /dev/null 2>&1 || [ ! -f "$checkpoint" ]; then
+    echo "checkpoint_test: a file that isn't a checkpoint is resumed, or removed"
+    status=1
+fi
+[ $status -eq 0 ] && echo "checkpoint_test: passed"
+exit $status
@@ -0,0 +1,51 @@
+#!/bin/sh
+#
+# Runs mdu with a deadline that passes before the tree can be read, and with one that doesn't. The first has to
+# print a lower bound of the total of [du], count the directories that weren't read, and still exit with status
+# 0. The second has to print the total of du, with no directory left unread.
+#
+
+mdu=${1:-./mdu}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir" "$dir.err"' EXIT
+
+for i in 1 2 3 4 5 6 7 8 9 10; do
+    for j in 1 2 3 4 5 6 7 8 9 10; do
+        mkdir -p "$dir/d$i/e$j"
+        head -c 5000 /dev/zero > "$dir/d$i/e$j/f"
+    done
+done
+expected=$(du -s -B 512 "$dir" | cut -f 1)
+
+#prints the value of a field of an ndjson record
+field() {
+    echo "$1" | sed -n "s/.*\"$2\":\([0-9]*\).*/\1/p"
+}
+
+status=0
+for threads in 1 4; do
+    record=$("$mdu" --deadline=0.000001 --format=ndjson -j "$threads" "$dir" 2> "$dir.err")
+    if [ $? -ne 0 ]; then
+        echo "deadline_test: mdu -j $threads exits with a failure status when the deadline passes"
+        status=1
+    fi
+    blocks=$(field "$record" blocks)
+    unvisited=$(field "$record" unvisited)
+    if [ -z "$blocks" ] || [ "$blocks" -ge "$expected" ] || [ "$unvisited" -eq 0 ]; then
+        echo "deadline_test: mdu -j $threads gives $blocks blocks and $unvisited unread directories after the" \
+             "deadline, du gives $expected blocks"
+        status=1
+    fi
+    if ! grep -q "deadline passed, $unvisited directories in '$dir' weren't read" "$dir.err"; then
+        echo "deadline_test: mdu -j $threads doesn't report the unread directories"
+        status=1
+    fi
+
+    record=$("$mdu" --deadline=1000 --format=ndjson -j "$threads" "$dir") || status=1
+    if [ "$(field "$record" blocks)" != "$expected" ] || [ "$(field "$record" unvisited)" != 0 ]; then
+        echo "deadline_test: mdu -j $threads doesn't give the total of du before the deadline"
+        status=1
+    fi
+done
+[ $status -eq 0 ] && echo "deadline_test: passed"
+exit $status
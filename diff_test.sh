@@ -0,0 +1,56 @@
+#!/bin/sh
+#
+# Saves a snapshot of a tree with mdu -s, changes the tree, and compares the snapshot with the changed tree with
+# --diff, both by scanning it and by loading a second snapshot. Every directory that grew or shrunk has to be
+# printed with the change that [du] gives, and no other directory.
+#
+
+mdu=${1:-./mdu}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir" "$dir.old" "$dir.new" "$dir.mdu" "$dir.du"' EXIT
+
+mkdir -p "$dir/a/b" "$dir/c" "$dir/d"
+for path in a/x a/b/y c/z d/w; do
+    head -c 9000 /dev/zero > "$dir/$path"
+done
+
+status=0
+"$mdu" -s "$dir.old" -j 4 "$dir" > /dev/null || status=1
+du -B 512 "$dir" > "$dir.du"
+rm -r "$dir/a/b"
+head -c 50000 /dev/zero > "$dir/c/v"
+mkdir "$dir/e"
+du -B 512 "$dir" | awk -F '\t' 'NR == FNR { old[$2] = $1; next }
+                                { delta = $1 - old[$2]; delete old[$2] }
+                                delta != 0 { printf "%+d\t%s\n", delta, $2 }
+                                END { for (path in old) printf "%+d\t%s\n", -old[path], path }' "$dir.du" - \
+    | sort > "$dir.du.delta"
+mv "$dir.du.delta" "$dir.du"
+
+"$mdu" --diff="$dir.old" --top=100 -j 4 "$dir" > "$dir.mdu" || status=1
+if [ "$(sort "$dir.mdu")" != "$(cat "$dir.du")" ]; then
+    echo "diff_test: --diff of the scanned tree prints other changes than du gives"
+    diff "$dir.mdu" "$dir.du"
+    status=1
+fi
+"$mdu" -s "$dir.new" "$dir" > /dev/null || status=1
+"$mdu" --diff="$dir.old" --load="$dir.new" --top=100 > "$dir.mdu" || status=1
+if [ "$(sort "$dir.mdu")" != "$(cat "$dir.du")" ]; then
+    echo "diff_test: --diff of a loaded snapshot prints other changes than du gives"
+    diff "$dir.mdu" "$dir.du"
+    status=1
+fi
+#the largest change comes first
+largest=$(sort -t "$(printf '\t')" -k 1,1gr "$dir.du" | head -n 1)
+if [ "$("$mdu" --diff="$dir.old" --top=1 "$dir")" != "$largest" ]; then
+    echo "diff_test: --diff --top=1 doesn't print the largest change"
+    status=1
+fi
+for flag in -a --histogram --by-owner --by-type -d1 --order=path; do
+    if "$mdu" --diff="$dir.old" "$flag" "$dir" > /dev/null 2>&1; then
+        echo "diff_test: --diff is accepted together with $flag"
+        status=1
+    fi
+done
+[ $status -eq 0 ] && echo "diff_test: passed"
+exit $status
@@ -0,0 +1,89 @@
+/**
+ * @brief This datatype keeps track of a directory while the size of it's file tree is being calculated.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 1.2
+ *
+ */
+
+#include "dir_node.h"
+
+Dir_node *create_dir_node(Dir_node *parent, const char *name, long id) {
+    size_t name_length = strlen(name);
+    Dir_node *node = malloc(sizeof(Dir_node) + name_length + 1);
+    error_handler_null(node, NULL, "dir node couldn't allocate memory", true);
+    node->parent = parent;
+    node->name_length = name_length;
+    memcpy(node->name, name, name_length + 1);
+    node->id = id;
+    node->depth = 0;
+    node->has_stat = false;
+    node->read_error = false;
+    node->sample_rate = 1;
+    node->fd = -1;
+    node->totals = (Mdu_totals) { 0 };
+    node->pending = 1;
+    pthread_mutex_init(&node->mutex, NULL);
+
+    if (parent != NULL) {
+        node->depth = parent->depth + 1;
+        pthread_mutex_lock(&parent->mutex);
+        parent->pending++;
+        pthread_mutex_unlock(&parent->mutex);
+    }
+    return node;
+}
+
+bool dir_node_release(Dir_node *node, const Mdu_totals *totals) {
+    pthread_mutex_lock(&node->mutex);
+    add_totals(&node->totals, totals);
+    node->pending--;
+    bool complete = node->pending == 0;
+    pthread_mutex_unlock(&node->mutex);
+    return complete;
+}
+
+char *dir_node_path(const Dir_node *node) {
+    size_t length = 0;
+    for (const Dir_node *n = node; n != NULL; n = n->parent) {
+        length += n->name_length + 1;
+    }
+    char *path = malloc(length + 1);
+    error_handler_null(path, NULL, "dir node couldn't allocate memory for a path", true);
+
+    //the names are written from the end, and the path is moved to the start if a root ended with '/'
+    size_t start = length;
+    path[start] = '\0';
+    for (const Dir_node *n = node; n != NULL; n = n->parent) {
+        start -= n->name_length;
+        memcpy(&path[start], n->name, n->name_length);
+        const Dir_node *parent = n->parent;
+        if (parent != NULL && (parent->name_length == 0 || parent->name[parent->name_length - 1] != '/')) {
+            path[--start] = '/';
+        }
+    }
+    memmove(path, &path[start], length - start + 1);
+    return path;
+}
+
+void add_totals(Mdu_totals *totals, const Mdu_totals *other) {
+    totals->block_size += other->block_size;
+    totals->bytes += other->bytes;
+    totals->file_amount += other->file_amount;
+    totals->dir_amount += other->dir_amount;
+    totals->error_amount += other->error_amount;
+    totals->unvisited_amount += other->unvisited_amount;
+    totals->variance += other->variance;
+    for (int i = 0; i < MDU_AGE_BUCKETS; i++) {
+        totals->age_block_size[i] += other->age_block_size[i];
+    }
+}
+
+void destroy_dir_node(Dir_node *node) {
+    if (node->fd >= 0) {
+        close(node->fd);
+    }
+    pthread_mutex_destroy(&node->mutex);
+    free(node);
+}
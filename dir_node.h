@@ -0,0 +1,124 @@
+/**
+ * @defgroup dir_node_h dir_node
+ *
+ * @brief This datatype keeps track of a directory while the size of it's file tree is being calculated.
+ *
+ * A directory node is pending as long as the directory itself, or any of the directories inside of it,
+ * hasn't been calculated. When the last of them is done, the node is complete and it's size is the total
+ * size of the file tree. The size is then added to the parent node.
+ *
+ * A node only holds the name of it's directory. The parent of a node is pending until the node is complete, so
+ * every node above a node is kept alive while it exists, and the whole path can be put together from the names
+ * of the nodes when it's needed.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 1.2
+ *
+ * @{
+ */
+
+#ifndef DIR_NODE_H
+#define DIR_NODE_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "libmdu.h"
+#include "error_handler.h"
+
+/**
+ * @brief                  A struct which is the structure for a directory node.
+ *
+ * @elem parent            The node of the directory that this directory is inside of. NULL for a root.
+ * @elem id                An id that no other directory in the scan has.
+ * @elem depth             How many directories below the root the directory is. 0 for a root.
+ * @elem stat              The struct stat of the directory, if has_stat is true.
+ * @elem has_stat          True if the directory could be stat'ed.
+ * @elem read_error        True if the directory couldn't be opened.
+ * @elem sample_rate       The probability that an estimate picked the directory. It's totals are scaled by
+ *                         the inverse when they are added to the parent. 1 if it was certain to be read.
+ * @elem fd                A file descriptor of the directory, opened by the directory that found it. -1 if
+ *                         it hasn't been opened.
+ * @elem totals            The totals of the directory, and of the completed directories inside of it.
+ * @elem pending           Amount of directories in the file tree that hasn't been completed, the directory
+ *                         itself included.
+ * @elem mutex             A variable for holding a mutex lock.
+ * @elem name_length       Amount of bytes in the name.
+ * @elem name              The name of the directory, null terminated. The whole path for a root.
+ */
+typedef struct dir_node {
+    struct dir_node *parent;
+    long id;
+    int depth;
+    struct stat stat;
+    bool has_stat;
+    bool read_error;
+    double sample_rate;
+    int fd;
+    Mdu_totals totals;
+    int pending;
+    pthread_mutex_t mutex;
+    size_t name_length;
+    char name[];
+} Dir_node;
+
+
+/**
+ * @brief                Creates a directory node, and allocates memory for it.
+ *
+ *                       The parent gets one more pending directory.
+ *
+ * @param parent         The node of the parent directory. NULL for a root.
+ * @param name           The name of the directory, the whole path for a root. It is copied into the node.
+ * @param id             An id that no other directory in the scan has.
+ * @return               Returns a directory node that has been dynamically allocated.
+ */
+Dir_node *create_dir_node(Dir_node *parent, const char *name, long id);
+
+
+/**
+ * @brief                Adds totals to the node and removes one pending directory from it.
+ *
+ * @param node           The node that the totals will be added upon.
+ * @param totals         The totals that will be added.
+ * @return               True if the node was completed, which is when it has no pending directories left.
+ */
+bool dir_node_release(Dir_node *node, const Mdu_totals *totals);
+
+
+/**
+ * @brief                Puts the path of a directory together, from the names of it and the nodes above it.
+ *
+ * @param node           The node of the directory.
+ * @return               The path, dynamically allocated.
+ */
+char *dir_node_path(const Dir_node *node);
+
+
+/**
+ * @brief                Adds totals onto other totals.
+ *
+ * @param totals         The totals that will be added upon.
+ * @param other          The totals that will be added.
+ */
+void add_totals(Mdu_totals *totals, const Mdu_totals *other);
+
+
+/**
+ * @brief                Deallocates the node, and closes it's file descriptor if it's open.
+ *
+ * @param node           The node that will be deallocated.
+ */
+void destroy_dir_node(Dir_node *node);
+
+#endif //DIR_NODE_H
+
+/**
+ * @}
+ */
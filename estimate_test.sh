@@ -0,0 +1,50 @@
+#!/bin/sh
+#
+# Runs mdu --estimate many times on a fixed tree, and compares the estimates with the total of [du]. The error of
+# most estimates has to be inside of their 95% confidence interval, and the mean of the estimates has to be close
+# to the total, as the estimate is unbiased. The bounds leave room for chance, so the test seldom fails by it.
+#
+
+mdu=${1:-./mdu}
+runs=40
+dir=$(mktemp -d)
+trap 'rm -rf "$dir" "$dir.mdu"' EXIT
+
+for i in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20; do
+    for j in 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20; do
+        mkdir -p "$dir/d$i/e$j"
+        head -c $(((i * j % 7 + 1) * 3000)) /dev/zero > "$dir/d$i/e$j/f"
+    done
+done
+expected=$(du -s -B 512 "$dir" | cut -f 1)
+
+status=0
+run=0
+: > "$dir.mdu"
+while [ $run -lt $runs ]; do
+    "$mdu" --estimate=0.3 --format=ndjson -j 4 "$dir" 2> /dev/null >> "$dir.mdu" || status=1
+    run=$((run + 1))
+done
+#at least 70% of the errors inside of the interval, where 95% are expected, and the mean within 3 times the
+#half width of the interval of the mean
+if ! sed 's/.*"blocks":\([0-9]*\).*"ci95":\([0-9]*\).*/\1 \2/' "$dir.mdu" \
+     | awk -v expected="$expected" -v runs="$runs" \
+           '{ error = $1 - expected; inside += (error < 0 ? -error : error) <= $2; sum += $1; width += $2; n++ }
+            END {
+                mean_error = sum / n - expected
+                mean_error = mean_error < 0 ? -mean_error : mean_error
+                if (n != runs || inside < 0.7 * n || mean_error > 3 * width / n / sqrt(n)) {
+                    printf "estimate_test: %d of %d estimates inside of their interval, mean %d, du gives %d\n",
+                           inside, n, sum / n, expected
+                    exit 1
+                }
+            }'; then
+    status=1
+fi
+#an estimate of every directory is the total
+if [ "$("$mdu" --estimate=1 "$dir" 2> /dev/null | cut -f 1)" != "$expected" ]; then
+    echo "estimate_test: --estimate=1 doesn't give the total of du"
+    status=1
+fi
+[ $status -eq 0 ] && echo "estimate_test: passed"
+exit $status
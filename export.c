@@ -0,0 +1,339 @@
+/**
+ * @brief This datatype writes the result of a scan as an export file of [ncdu], which can be opened with ncdu -f.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 1.0
+ *
+ */
+
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "export.h"
+#include "output.h"
+
+static off_t write_info(FILE *file, const char *name, const struct stat *stat, bool read_error);
+static void close_piece(Export *export, int spool);
+static Export_dir *find_dir(Export *export, long id);
+static size_t hash_id(long id, size_t table_size);
+static void write_tree(Export *export, Export_dir *root, bool is_dir);
+static void copy_piece(Export *export, const Export_piece *piece, char *buffer);
+static void clear_table(Export *export);
+
+Export *create_export(FILE *file, int spool_amount) {
+    Export *export = malloc(sizeof(Export));
+    error_handler_null(export, NULL, "export couldn't allocate memory", true);
+    export->file = file;
+    export->spool_amount = spool_amount;
+    export->spools = malloc(spool_amount * sizeof(Export_spool *));
+    error_handler_null(export->spools, NULL, "export spools couldn't allocate memory", true);
+    for (int i = 0; i < spool_amount; i++) {
+        Export_spool *spool = malloc(sizeof(Export_spool));
+        error_handler_null(spool, NULL, "export spool couldn't allocate memory", true);
+        spool->file = tmpfile();
+        error_handler_null(spool->file, NULL, "export spool file couldn't be created", true);
+        setvbuf(spool->file, NULL, _IOFBF, EXPORT_COPY_SIZE);
+        spool->length = 0;
+        spool->parent_id = 0;
+        spool->piece_start = 0;
+        export->spools[i] = spool;
+    }
+    export->table_size = EXPORT_TABLE_SIZE;
+    export->table = calloc(export->table_size, sizeof(Export_dir *));
+    error_handler_null(export->table, NULL, "export table couldn't allocate memory", true);
+    export->dir_amount = 0;
+    pthread_mutex_init(&export->mutex, NULL);
+
+    fprintf(file, "[%d,%d,{\"progname\":\"mdu\",\"timestamp\":%ld},\n", EXPORT_MAJOR_VERSION,
+            EXPORT_MINOR_VERSION, (long)time(NULL));
+    return export;
+}
+
+void export_file(Export *export, const Mdu_entry *entry) {
+    if (entry->depth == 0) {
+        return;
+    }
+    Export_spool *spool = export->spools[entry->worker];
+    //the files of a directory are contiguous, until the thread goes into another directory
+    if (spool->parent_id != entry->parent_id) {
+        close_piece(export, entry->worker);
+        spool->parent_id = entry->parent_id;
+        spool->piece_start = spool->length;
+    }
+    fputs(",\n", spool->file);
+    spool->length += 2;
+    spool->length += write_info(spool->file, strrchr(entry->path, '/') + 1, entry->stat, false);
+}
+
+void export_dir(Export *export, const Mdu_entry *entry) {
+    Export_spool *spool = export->spools[entry->worker];
+    close_piece(export, entry->worker);
+
+    const char *name = entry->depth == 0 ? entry->path : strrchr(entry->path, '/') + 1;
+    Export_piece info = { .spool = entry->worker, .offset = spool->length, .next = NULL };
+    info.length = write_info(spool->file, name, entry->stat, entry->read_error);
+    spool->length += info.length;
+
+    pthread_mutex_lock(&export->mutex);
+    Export_dir *dir = find_dir(export, entry->id);
+    dir->info = info;
+    if (entry->parent_id != 0) {
+        Export_dir *parent = find_dir(export, entry->parent_id);
+        dir->sibling = parent->children;
+        parent->children = dir;
+    }
+    pthread_mutex_unlock(&export->mutex);
+
+    if (entry->depth == 0) {
+        write_tree(export, dir, entry->stat != NULL && S_ISDIR(entry->stat->st_mode));
+        clear_table(export);
+    }
+}
+
+void destroy_export(Export *export) {
+    fputs("]\n", export->file);
+    error_handler_value(0, fflush(export->file), NULL, "export couldn't be written", true);
+    error_handler_value(0, -ferror(export->file), NULL, "export couldn't be written", false);
+    clear_table(export);
+    for (int i = 0; i < export->spool_amount; i++) {
+        fclose(export->spools[i]->file);
+        free(export->spools[i]);
+    }
+    free(export->spools);
+    free(export->table);
+    pthread_mutex_destroy(&export->mutex);
+    free(export);
+}
+
+/**
+ * @brief                Writes the information block of a file or a directory.
+ *
+ * @param file           The file that the block is written to.
+ * @param name           The name of the file or directory.
+ * @param stat           The struct stat of it. NULL if it couldn't be stat'ed.
+ * @param read_error     True if it is a directory that couldn't be opened.
+ * @return               Amount of bytes written.
+ */
+static off_t write_info(FILE *file, const char *name, const struct stat *stat, bool read_error) {
+    char short_name[NAME_MAX * 6 + 3];
+    size_t name_length = strlen(name);
+    char *escaped = short_name;
+    if (name_length > NAME_MAX) {
+        escaped = malloc(name_length * 6 + 3);
+        error_handler_null(escaped, NULL, "export name couldn't allocate memory", true);
+    }
+    json_escape(escaped, name);
+
+    int length;
+    if (stat == NULL) {
+        length = fprintf(file, "{\"name\":%s,\"read_error\":true}", escaped);
+    } else {
+        length = fprintf(file, "{\"name\":%s,\"asize\":%lld,\"dsize\":%lld", escaped, (long long)stat->st_size,
+                         (long long)stat->st_blocks * 512);
+        if (S_ISDIR(stat->st_mode)) {
+            length += fprintf(file, ",\"dev\":%llu", (unsigned long long)stat->st_dev);
+        } else if (stat->st_nlink > 1) {
+            length += fprintf(file, ",\"hlnkc\":true,\"nlink\":%lu", (unsigned long)stat->st_nlink);
+        }
+        length += fprintf(file, ",\"ino\":%llu", (unsigned long long)stat->st_ino);
+        if (!S_ISDIR(stat->st_mode) && !S_ISREG(stat->st_mode)) {
+            length += fprintf(file, ",\"notreg\":true");
+        }
+        if (read_error) {
+            length += fprintf(file, ",\"read_error\":true");
+        }
+        length += fprintf(file, "}");
+    }
+    if (escaped != short_name) {
+        free(escaped);
+    }
+    return length;
+}
+
+/**
+ * @brief                Ends the current piece of a spool file, and adds it to the directory it belongs to.
+ *
+ * @param export         The export.
+ * @param spool          The index of the spool file.
+ */
+static void close_piece(Export *export, int spool) {
+    Export_spool *current = export->spools[spool];
+    if (current->parent_id != 0 && current->length > current->piece_start) {
+        Export_piece *piece = malloc(sizeof(Export_piece));
+        error_handler_null(piece, NULL, "export piece couldn't allocate memory", true);
+        piece->spool = spool;
+        piece->offset = current->piece_start;
+        piece->length = current->length - current->piece_start;
+
+        pthread_mutex_lock(&export->mutex);
+        Export_dir *dir = find_dir(export, current->parent_id);
+        piece->next = dir->pieces;
+        dir->pieces = piece;
+        pthread_mutex_unlock(&export->mutex);
+    }
+    current->parent_id = 0;
+}
+
+/**
+ * @brief                Finds a directory in the table, and adds it if it isn't there. The table grows when
+ *                       it holds more than two directories per slot.
+ *
+ *                       The mutex of the export must be held.
+ *
+ * @param export         The export.
+ * @param id             The id of the directory.
+ * @return               Returns the directory.
+ */
+static Export_dir *find_dir(Export *export, long id) {
+    size_t slot = hash_id(id, export->table_size);
+    for (Export_dir *dir = export->table[slot]; dir != NULL; dir = dir->hash_next) {
+        if (dir->id == id) {
+            return dir;
+        }
+    }
+
+    if (export->dir_amount >= export->table_size * 2) {
+        size_t table_size = export->table_size * 2;
+        Export_dir **table = calloc(table_size, sizeof(Export_dir *));
+        error_handler_null(table, NULL, "export table couldn't allocate memory", true);
+        for (size_t i = 0; i < export->table_size; i++) {
+            while (export->table[i] != NULL) {
+                Export_dir *moved = export->table[i];
+                export->table[i] = moved->hash_next;
+                size_t new_slot = hash_id(moved->id, table_size);
+                moved->hash_next = table[new_slot];
+                table[new_slot] = moved;
+            }
+        }
+        free(export->table);
+        export->table = table;
+        export->table_size = table_size;
+        slot = hash_id(id, table_size);
+    }
+
+    Export_dir *dir = calloc(1, sizeof(Export_dir));
+    error_handler_null(dir, NULL, "export directory couldn't allocate memory", true);
+    dir->id = id;
+    dir->hash_next = export->table[slot];
+    export->table[slot] = dir;
+    export->dir_amount++;
+    return dir;
+}
+
+/**
+ * @brief                Gives the slot of an id in a table.
+ *
+ * @param id             The id.
+ * @param table_size     Amount of slots in the table, a power of two.
+ * @return               The slot.
+ */
+static size_t hash_id(long id, size_t table_size) {
+    return (size_t)(((unsigned long long)id * 11400714819323198485ull) >> 32) & (table_size - 1);
+}
+
+/**
+ * @brief                Writes the tree of a root to the export file, by walking the skeleton depth first and
+ *                       copying the pieces of every directory from the spool files.
+ *
+ *                       A directory is written as an array with it's information first, followed by it's
+ *                       files and directories.
+ *
+ * @param export         The export.
+ * @param root           The directory of the root.
+ * @param is_dir         False if the root isn't a directory, and is written as a single information block.
+ */
+static void write_tree(Export *export, Export_dir *root, bool is_dir) {
+    for (int i = 0; i < export->spool_amount; i++) {
+        close_piece(export, i);
+        error_handler_value(0, fflush(export->spools[i]->file), NULL, "export spool couldn't be written", true);
+    }
+    char *buffer = malloc(EXPORT_COPY_SIZE);
+    error_handler_null(buffer, NULL, "export buffer couldn't allocate memory", true);
+    if (!is_dir) {
+        copy_piece(export, &root->info, buffer);
+        fputs("\n", export->file);
+        free(buffer);
+        return;
+    }
+
+    //the stack holds the directories that are being written, and the next directory inside of each
+    size_t stack_capacity = 64;
+    size_t stack_length = 0;
+    Export_dir **stack = malloc(stack_capacity * sizeof(Export_dir *));
+    error_handler_null(stack, NULL, "export stack couldn't allocate memory", true);
+    Export_dir *dir = root;
+    while (true) {
+        if (dir != NULL) {
+            fputc('[', export->file);
+            copy_piece(export, &dir->info, buffer);
+            for (Export_piece *piece = dir->pieces; piece != NULL; piece = piece->next) {
+                copy_piece(export, piece, buffer);
+            }
+            if (stack_length == stack_capacity) {
+                stack_capacity *= 2;
+                stack = realloc(stack, stack_capacity * sizeof(Export_dir *));
+                error_handler_null(stack, NULL, "export stack couldn't allocate memory", true);
+            }
+            stack[stack_length++] = dir;
+            dir = dir->children;
+        } else if (stack_length > 0) {
+            //the directory on top is done when it has no more directories inside of it to write
+            fputc(']', export->file);
+            dir = stack[--stack_length]->sibling;
+            if (stack_length == 0) {
+                break;
+            }
+        } else {
+            break;
+        }
+        if (dir != NULL) {
+            fputs(",\n", export->file);
+        }
+    }
+    fputs("\n", export->file);
+    free(stack);
+    free(buffer);
+}
+
+/**
+ * @brief                Copies a piece from it's spool file to the export file.
+ *
+ * @param export         The export.
+ * @param piece          The piece.
+ * @param buffer         A buffer of EXPORT_COPY_SIZE bytes.
+ */
+static void copy_piece(Export *export, const Export_piece *piece, char *buffer) {
+    int fd = fileno(export->spools[piece->spool]->file);
+    size_t copied = 0;
+    while (copied < piece->length) {
+        size_t amount = piece->length - copied < EXPORT_COPY_SIZE ? piece->length - copied : EXPORT_COPY_SIZE;
+        ssize_t check = pread(fd, buffer, amount, piece->offset + copied);
+        error_handler_value(1, check < 1 ? 0 : 1, NULL, "export spool couldn't be read", true);
+        fwrite(buffer, 1, check, export->file);
+        copied += check;
+    }
+}
+
+/**
+ * @brief                Removes every directory and piece from the table.
+ *
+ * @param export         The export.
+ */
+static void clear_table(Export *export) {
+    for (size_t i = 0; i < export->table_size; i++) {
+        while (export->table[i] != NULL) {
+            Export_dir *dir = export->table[i];
+            export->table[i] = dir->hash_next;
+            while (dir->pieces != NULL) {
+                Export_piece *piece = dir->pieces;
+                dir->pieces = piece->next;
+                free(piece);
+            }
+            free(dir);
+        }
+    }
+    export->dir_amount = 0;
+}
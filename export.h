@@ -0,0 +1,153 @@
+/**
+ * @defgroup export_h export
+ *
+ * @brief This datatype writes the result of a scan as an export file of [ncdu], which can be opened with ncdu -f.
+ *
+ * The export is a tree where every directory holds it's files and directories, but a parallel scan finds them in
+ * any order. The records of the files, and the information of the directories, are therefore streamed to one
+ * spool file per thread, as pieces that belongs to a directory. Only a skeleton of the directories, with where
+ * their pieces are in the spool files, is kept in memory. When the root is complete the skeleton is walked, and
+ * the pieces are copied from the spool files into the export in the order of the tree.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 1.0
+ *
+ * @{
+ */
+
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "libmdu.h"
+#include "error_handler.h"
+
+#define EXPORT_MAJOR_VERSION 1
+#define EXPORT_MINOR_VERSION 2
+#define EXPORT_TABLE_SIZE 1024
+#define EXPORT_COPY_SIZE 65536
+
+/**
+ * @brief                  A struct which is the structure for a piece of a spool file.
+ *
+ * @elem spool             The index of the spool file.
+ * @elem offset            The offset in the spool file where the piece starts.
+ * @elem length            Amount of bytes in the piece.
+ * @elem next              The next piece of the same directory.
+ */
+typedef struct export_piece {
+    int spool;
+    off_t offset;
+    size_t length;
+    struct export_piece *next;
+} Export_piece;
+
+/**
+ * @brief                  A struct which is the structure for a directory in the skeleton.
+ *
+ * @elem id                The id of the directory, from the entries of the scan.
+ * @elem info              The piece with the information of the directory. Has length 0 until the directory
+ *                         is complete.
+ * @elem pieces            The pieces with the records of the files directly inside of the directory.
+ * @elem children          The first directory directly inside of the directory.
+ * @elem sibling           The next directory inside of the same parent.
+ * @elem hash_next         The next directory in the same slot of the table.
+ */
+typedef struct export_dir {
+    long id;
+    Export_piece info;
+    Export_piece *pieces;
+    struct export_dir *children;
+    struct export_dir *sibling;
+    struct export_dir *hash_next;
+} Export_dir;
+
+/**
+ * @brief                  A struct which is the structure for the spool file of one thread.
+ *
+ * @elem file              The spool file.
+ * @elem length            Amount of bytes written to the spool file.
+ * @elem parent_id         The id of the directory that the current piece belongs to. 0 if there is no piece.
+ * @elem piece_start       The offset where the current piece starts.
+ */
+typedef struct export_spool {
+    FILE *file;
+    off_t length;
+    long parent_id;
+    off_t piece_start;
+} Export_spool;
+
+/**
+ * @brief                  A struct which is the structure for an export.
+ *
+ * @elem file              The export file.
+ * @elem spools            An array of pointers to the spool files, one for each thread.
+ * @elem spool_amount      Amount of spool files.
+ * @elem table             A hash table of the directories in the skeleton, by their ids.
+ * @elem table_size        Amount of slots in the table.
+ * @elem dir_amount        Amount of directories in the table.
+ * @elem mutex             A variable for holding a mutex lock, for the table and the skeleton.
+ */
+typedef struct export {
+    FILE *file;
+    Export_spool **spools;
+    int spool_amount;
+    Export_dir **table;
+    size_t table_size;
+    size_t dir_amount;
+    pthread_mutex_t mutex;
+} Export;
+
+
+/**
+ * @brief                Creates an export, and allocates memory for it. The header of the export is written
+ *                       to the file.
+ *
+ * @param file           The file that the export is written to.
+ * @param spool_amount   Amount of spool files, one for each thread that gives entries.
+ * @return               Returns an export that has been dynamically allocated.
+ */
+Export *create_export(FILE *file, int spool_amount);
+
+
+/**
+ * @brief                Adds a file to the spool file of the thread that found it. A root that is a file is
+ *                       added by export_dir.
+ *
+ * @param export         The export.
+ * @param entry          The file.
+ */
+void export_file(Export *export, const Mdu_entry *entry);
+
+
+/**
+ * @brief                Adds a completed directory to the spool file of the thread that completed it, and to
+ *                       the skeleton. When the root is added, the tree is written to the export file.
+ *
+ *                       The root has to be the only entry that is added while the tree is written, which is
+ *                       the case for the directory callback of a scan.
+ *
+ * @param export         The export.
+ * @param entry          The directory.
+ */
+void export_dir(Export *export, const Mdu_entry *entry);
+
+
+/**
+ * @brief                Ends the export file, and deallocates the export and it's spool files.
+ *
+ * @param export         The export that will be deallocated.
+ */
+void destroy_export(Export *export);
+
+#endif //EXPORT_H
+
+/**
+ * @}
+ */
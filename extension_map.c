@@ -0,0 +1,195 @@
+/**
+ * @brief This datatype is a map from the file type and extension of files, to the amount of files and blocks
+ * that have them.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 1.0
+ *
+ */
+
+#include <string.h>
+#include "extension_map.h"
+
+static uint64_t hash_extension(Mdu_file_type type, const char *extension, size_t length);
+static const char *intern_extension(Extension_map *map, const char *extension, size_t length);
+static void grow_map(Extension_map *map);
+static int compare_extensions(const void *extension, const void *other);
+
+Extension_map *create_extension_map(void) {
+    Extension_map *map = malloc(sizeof(Extension_map));
+    error_handler_null(map, NULL, "extension map couldn't allocate memory", true);
+    map->slots = NULL;
+    map->amount = 0;
+    map->capacity = 0;
+    map->chunks = NULL;
+    map->name_size = 0;
+    return map;
+}
+
+void extension_map_add(Extension_map *map, Mdu_file_type type, const char *extension, size_t length,
+                       long file_amount, blkcnt_t block_size) {
+    if (2 * (map->amount + 1) > map->capacity) {
+        grow_map(map);
+    }
+    uint64_t hash = hash_extension(type, extension, length);
+    size_t mask = map->capacity - 1;
+    size_t slot = hash & mask;
+    while (map->slots[slot].used) {
+        Extension_slot *current = &map->slots[slot];
+        if (current->hash == hash && current->extension.type == type && current->length == length
+            && memcmp(current->extension.extension, extension, length) == 0) {
+            current->extension.file_amount += file_amount;
+            current->extension.block_size += block_size;
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+    map->slots[slot] = (Extension_slot) {
+        .extension = { .type = type, .extension = intern_extension(map, extension, length),
+                       .file_amount = file_amount, .block_size = block_size },
+        .length = length, .hash = hash, .used = true
+    };
+    map->amount++;
+}
+
+void extension_map_merge(Extension_map *map, const Extension_map *other) {
+    for (size_t i = 0; i < other->capacity; i++) {
+        const Extension_slot *slot = &other->slots[i];
+        if (slot->used) {
+            extension_map_add(map, slot->extension.type, slot->extension.extension, slot->length,
+                              slot->extension.file_amount, slot->extension.block_size);
+        }
+    }
+}
+
+Mdu_extension *extension_map_sorted(const Extension_map *map) {
+    if (map->amount == 0) {
+        return NULL;
+    }
+    Mdu_extension *extensions = malloc(map->amount * sizeof(Mdu_extension) + map->name_size);
+    error_handler_null(extensions, NULL, "extension map couldn't allocate memory", true);
+    char *names = (char *)&extensions[map->amount];
+    size_t amount = 0;
+    for (size_t i = 0; i < map->capacity; i++) {
+        const Extension_slot *slot = &map->slots[i];
+        if (slot->used) {
+            extensions[amount] = slot->extension;
+            extensions[amount++].extension = memcpy(names, slot->extension.extension, slot->length + 1);
+            names += slot->length + 1;
+        }
+    }
+    qsort(extensions, amount, sizeof(Mdu_extension), compare_extensions);
+    return extensions;
+}
+
+void extension_map_clear(Extension_map *map) {
+    if (map->slots != NULL) {
+        memset(map->slots, 0, map->capacity * sizeof(Extension_slot));
+    }
+    //the first chunk is kept for the next extensions
+    while (map->chunks != NULL && map->chunks->next != NULL) {
+        Extension_chunk *next = map->chunks->next;
+        free(map->chunks);
+        map->chunks = next;
+    }
+    if (map->chunks != NULL) {
+        map->chunks->used = 0;
+    }
+    map->amount = 0;
+    map->name_size = 0;
+}
+
+void destroy_extension_map(Extension_map *map) {
+    while (map->chunks != NULL) {
+        Extension_chunk *next = map->chunks->next;
+        free(map->chunks);
+        map->chunks = next;
+    }
+    free(map->slots);
+    free(map);
+}
+
+/**
+ * @brief                Hashes a file type and an extension, with FNV-1a.
+ *
+ * @param type           The file type.
+ * @param extension      The extension.
+ * @param length         The length of the extension.
+ * @return               The hash.
+ */
+static uint64_t hash_extension(Mdu_file_type type, const char *extension, size_t length) {
+    uint64_t hash = 0xCBF29CE484222325ULL ^ (uint64_t)type;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)extension[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+/**
+ * @brief                Copies an extension into the chunks of the map, and allocates a new chunk when the
+ *                       last one is full.
+ *
+ * @param map            The map.
+ * @param extension      The extension.
+ * @param length         The length of the extension.
+ * @return               The interned extension, null terminated.
+ */
+static const char *intern_extension(Extension_map *map, const char *extension, size_t length) {
+    if (map->chunks == NULL || map->chunks->used + length + 1 > EXTENSION_CHUNK_SIZE) {
+        Extension_chunk *chunk = malloc(sizeof(Extension_chunk));
+        error_handler_null(chunk, NULL, "extension map couldn't allocate memory", true);
+        chunk->next = map->chunks;
+        chunk->used = 0;
+        map->chunks = chunk;
+    }
+    char *name = &map->chunks->names[map->chunks->used];
+    memcpy(name, extension, length);
+    name[length] = '\0';
+    map->chunks->used += length + 1;
+    map->name_size += length + 1;
+    return name;
+}
+
+/**
+ * @brief                Doubles the hash table of the map, and places every extension again.
+ *
+ * @param map            The map.
+ */
+static void grow_map(Extension_map *map) {
+    size_t capacity = map->capacity == 0 ? EXTENSION_MAP_START_CAPACITY : map->capacity * 2;
+    Extension_slot *slots = calloc(capacity, sizeof(Extension_slot));
+    error_handler_null(slots, NULL, "extension map couldn't allocate memory", true);
+    for (size_t i = 0; i < map->capacity; i++) {
+        if (map->slots[i].used) {
+            size_t slot = map->slots[i].hash & (capacity - 1);
+            while (slots[slot].used) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            slots[slot] = map->slots[i];
+        }
+    }
+    free(map->slots);
+    map->slots = slots;
+    map->capacity = capacity;
+}
+
+/**
+ * @brief                Compares two extensions for qsort, by their blocks with the most first, and by their
+ *                       file types and names.
+ *
+ * @param extension      The first extension.
+ * @param other          The second extension.
+ * @return               Negative if extension comes first, positive if other does.
+ */
+static int compare_extensions(const void *extension, const void *other) {
+    const Mdu_extension *a = extension;
+    const Mdu_extension *b = other;
+    if (a->block_size != b->block_size) {
+        return a->block_size > b->block_size ? -1 : 1;
+    }
+    if (a->type != b->type) {
+        return a->type < b->type ? -1 : 1;
+    }
+    return strcmp(a->extension, b->extension);
+}
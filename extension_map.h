@@ -0,0 +1,142 @@
+/**
+ * @defgroup extension_map_h extension_map
+ *
+ * @brief This datatype is a map from the file type and extension of files, to the amount of files and blocks
+ * that have them.
+ *
+ * A map is only used by one thread, so it isn't locked. It's a hash table with open addressing, which is
+ * doubled when it's half full. Every extension is interned, copied once into the chunks of the map, so the
+ * slots only hold a pointer to it. The maps of several threads are added together with extension_map_merge.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 1.0
+ *
+ * @{
+ */
+
+#ifndef EXTENSION_MAP_H
+#define EXTENSION_MAP_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "libmdu.h"
+#include "error_handler.h"
+
+#define EXTENSION_MAP_START_CAPACITY 64
+#define EXTENSION_CHUNK_SIZE 4096
+
+/**
+ * @brief                  A struct which is the structure for a slot of the map.
+ *
+ * @elem extension         The file type and interned extension, with it's files and blocks.
+ * @elem length            The length of the extension.
+ * @elem hash              The hash of the file type and extension.
+ * @elem used              True if the slot holds an extension.
+ */
+typedef struct extension_slot {
+    Mdu_extension extension;
+    size_t length;
+    uint64_t hash;
+    bool used;
+} Extension_slot;
+
+/**
+ * @brief                  A struct which is the structure for a chunk of the interned extensions.
+ *
+ * @elem next              The chunk that was filled before this one. NULL for the first chunk.
+ * @elem used              Amount of bytes of the chunk that hold extensions.
+ * @elem names             The extensions, null terminated.
+ */
+typedef struct extension_chunk {
+    struct extension_chunk *next;
+    size_t used;
+    char names[EXTENSION_CHUNK_SIZE];
+} Extension_chunk;
+
+/**
+ * @brief                  A struct which is the structure for the map.
+ *
+ * @elem slots             The hash table, NULL until the first extension is added.
+ * @elem amount            Amount of extensions in the map.
+ * @elem capacity          Amount of slots in the hash table, a power of 2.
+ * @elem chunks            The chunk that extensions are interned into, the last one that was allocated.
+ * @elem name_size         Amount of bytes of every interned extension, the null terminators included.
+ */
+typedef struct extension_map {
+    Extension_slot *slots;
+    size_t amount;
+    size_t capacity;
+    Extension_chunk *chunks;
+    size_t name_size;
+} Extension_map;
+
+
+/**
+ * @brief                Creates an empty map, and allocates memory for it.
+ *
+ * @return               Returns a map that has been dynamically allocated.
+ */
+Extension_map *create_extension_map(void);
+
+
+/**
+ * @brief                Adds files and blocks to a file type and extension, which is added to the map if it isn't
+ *                       in it.
+ *
+ * @param map            The map.
+ * @param type           The file type.
+ * @param extension      The extension, which doesn't have to be null terminated. At most MDU_EXTENSION_MAX
+ *                       bytes.
+ * @param length         The length of the extension, 0 for files without one.
+ * @param file_amount    Amount of files that are added.
+ * @param block_size     Amount of blocks that are added.
+ */
+void extension_map_add(Extension_map *map, Mdu_file_type type, const char *extension, size_t length,
+                       long file_amount, blkcnt_t block_size);
+
+
+/**
+ * @brief                Adds every extension of a map to another map.
+ *
+ * @param map            The map that is added to.
+ * @param other          The map that is added.
+ */
+void extension_map_merge(Extension_map *map, const Extension_map *other);
+
+
+/**
+ * @brief                Copies the extensions of the map to an array, with the extension of the most blocks
+ *                       first. The extensions are copied to the end of the same allocation, so freeing the array
+ *                       frees them as well.
+ *
+ * @param map            The map.
+ * @return               Returns an array of map->amount extensions that has been dynamically allocated. NULL if
+ *                       the map is empty.
+ */
+Mdu_extension *extension_map_sorted(const Extension_map *map);
+
+
+/**
+ * @brief                Removes every extension from the map.
+ *
+ * @param map            The map.
+ */
+void extension_map_clear(Extension_map *map);
+
+
+/**
+ * @brief                Deallocates the map.
+ *
+ * @param map            The map that will be deallocated.
+ */
+void destroy_extension_map(Extension_map *map);
+
+#endif //EXTENSION_MAP_H
+
+/**
+ * @}
+ */
@@ -0,0 +1,39 @@
+#!/bin/sh
+#
+# Compares the total of mdu with the one of [du] when the file descriptor limit is too low for the directories that
+# the threads would want to hold open. The tree is wide, so that tasks would carry their directories, and deeper than
+# PATH_MAX, so that the threads have to open the ancestors of a path to get to it.
+#
+
+mdu=${1:-./mdu}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+name=$(head -c 200 /dev/zero | tr '\0' 'd')
+(
+    cd "$dir" || exit 1
+    i=0
+    while [ $i -lt 300 ]; do
+        mkdir "w$i" && head -c 3000 /dev/zero > "w$i/f"
+        i=$((i + 1))
+    done
+    i=0
+    while [ $i -lt 25 ]; do
+        mkdir "$name" && cd -P "$name" && mkdir a b && head -c 5000 /dev/zero > f || exit 1
+        i=$((i + 1))
+    done
+) || { echo "fd_limit_test: can't make the tree"; exit 1; }
+
+expected=$(du -s -B 512 "$dir" | cut -f 1)
+status=0
+for threads in 1 8; do
+    for limit in 16 24; do
+        total=$(ulimit -n $limit && "$mdu" -j "$threads" "$dir" | cut -f 1) || status=1
+        if [ "$total" != "$expected" ]; then
+            echo "fd_limit_test: mdu -j $threads under ulimit -n $limit gives $total blocks, du gives $expected"
+            status=1
+        fi
+    done
+done
+[ $status -eq 0 ] && echo "fd_limit_test: passed"
+exit $status
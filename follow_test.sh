@@ -0,0 +1,49 @@
+#!/bin/sh
+#
+# Runs mdu -L on a tree with symbolic links that make cycles, to the root, to an ancestor and to the directory
+# itself, a link to a directory that is also reached without it, and a link out of the tree. The scan has to end,
+# and give the total of [du] -L, where every directory is counted once. mdu -H is compared with du -H, through a
+# link to the tree.
+#
+
+mdu=${1:-./mdu}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir" "$dir.link" "$dir.outside"' EXIT
+
+mkdir -p "$dir/a/b/c" "$dir/s/t"
+head -c 7000 /dev/zero > "$dir/a/b/c/f"
+head -c 3000 /dev/zero > "$dir/s/t/g"
+mkdir "$dir.outside"
+head -c 20000 /dev/zero > "$dir.outside/h"
+ln -s ../.. "$dir/a/b/up"
+ln -s .. "$dir/a/b/c/loop"
+ln -s . "$dir/a/self"
+ln -s ../../.. "$dir/a/b/c/root"
+ln -s ../s "$dir/a/to_s"
+ln -s "$dir.outside" "$dir/s/out"
+ln -s "$dir" "$dir.link"
+
+status=0
+expected=$(du -s -L -B 512 "$dir" | cut -f 1)
+if [ "$expected" -le "$(du -s -B 512 "$dir" | cut -f 1)" ]; then
+    echo "follow_test: du -L doesn't follow the link out of the tree"
+    status=1
+fi
+for threads in 1 4; do
+    #a scan that doesn't end is stopped, and fails
+    total=$(timeout 60 "$mdu" -L -j "$threads" "$dir" | cut -f 1)
+    if [ "$total" != "$expected" ]; then
+        echo "follow_test: mdu -L -j $threads gives '$total' blocks, du -L gives $expected"
+        status=1
+    fi
+done
+if [ "$("$mdu" -H "$dir.link")" != "$(du -s -H -B 512 "$dir.link")" ]; then
+    echo "follow_test: mdu -H of a link to the tree doesn't give the total of du -H"
+    status=1
+fi
+if [ "$("$mdu" "$dir.link")" != "$(du -s -B 512 "$dir.link")" ]; then
+    echo "follow_test: mdu of a link to the tree follows the link"
+    status=1
+fi
+[ $status -eq 0 ] && echo "follow_test: passed"
+exit $status
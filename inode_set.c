@@ -0,0 +1,145 @@
+/**
+ * @brief This datatype is a set of files, identified by their device and inode numbers, that several threads
+ * can add to at the same time.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 1.0
+ *
+ */
+
+#include <string.h>
+#include "inode_set.h"
+
+static uint64_t hash_inode(dev_t dev, ino_t ino);
+static void place_key(Inode_key *keys, size_t capacity, size_t slot, Inode_key key);
+static void grow_shard(Inode_set_shard *shard);
+
+Inode_set *create_inode_set(void) {
+    Inode_set *set = malloc(sizeof(Inode_set));
+    error_handler_null(set, NULL, "inode set couldn't allocate memory", true);
+    for (int i = 0; i < INODE_SET_SHARDS; i++) {
+        set->shards[i].keys = NULL;
+        set->shards[i].amount = 0;
+        set->shards[i].capacity = 0;
+        pthread_mutex_init(&set->shards[i].mutex, NULL);
+    }
+    return set;
+}
+
+bool inode_set_insert(Inode_set *set, dev_t dev, ino_t ino) {
+    uint64_t hash = hash_inode(dev, ino);
+    //the shard is taken from the high bits, and the slot from the low bits
+    Inode_set_shard *shard = &set->shards[hash >> (64 - INODE_SET_SHARD_BITS)];
+    pthread_mutex_lock(&shard->mutex);
+    if (2 * (shard->amount + 1) > shard->capacity) {
+        grow_shard(shard);
+    }
+    size_t mask = shard->capacity - 1;
+    size_t slot = hash & mask;
+    while (shard->keys[slot].used) {
+        if (shard->keys[slot].dev == dev && shard->keys[slot].ino == ino) {
+            pthread_mutex_unlock(&shard->mutex);
+            return false;
+        }
+        slot = (slot + 1) & mask;
+    }
+    shard->keys[slot] = (Inode_key) { .dev = dev, .ino = ino, .used = true };
+    shard->amount++;
+    pthread_mutex_unlock(&shard->mutex);
+    return true;
+}
+
+Inode_key *inode_set_keys(Inode_set *set, size_t *amount) {
+    *amount = 0;
+    for (int i = 0; i < INODE_SET_SHARDS; i++) {
+        *amount += set->shards[i].amount;
+    }
+    if (*amount == 0) {
+        return NULL;
+    }
+    Inode_key *keys = malloc(*amount * sizeof(Inode_key));
+    error_handler_null(keys, NULL, "inode set couldn't allocate memory", true);
+    size_t index = 0;
+    for (int i = 0; i < INODE_SET_SHARDS; i++) {
+        Inode_set_shard *shard = &set->shards[i];
+        pthread_mutex_lock(&shard->mutex);
+        for (size_t j = 0; j < shard->capacity; j++) {
+            if (shard->keys[j].used) {
+                keys[index++] = shard->keys[j];
+            }
+        }
+        pthread_mutex_unlock(&shard->mutex);
+    }
+    return keys;
+}
+
+void inode_set_clear(Inode_set *set) {
+    for (int i = 0; i < INODE_SET_SHARDS; i++) {
+        Inode_set_shard *shard = &set->shards[i];
+        pthread_mutex_lock(&shard->mutex);
+        if (shard->keys != NULL) {
+            memset(shard->keys, 0, shard->capacity * sizeof(Inode_key));
+        }
+        shard->amount = 0;
+        pthread_mutex_unlock(&shard->mutex);
+    }
+}
+
+void destroy_inode_set(Inode_set *set) {
+    for (int i = 0; i < INODE_SET_SHARDS; i++) {
+        free(set->shards[i].keys);
+        pthread_mutex_destroy(&set->shards[i].mutex);
+    }
+    free(set);
+}
+
+/**
+ * @brief                Hashes the device and inode numbers of a file, with the finalizer of splitmix64.
+ *
+ * @param dev            The device number.
+ * @param ino            The inode number.
+ * @return               The hash.
+ */
+static uint64_t hash_inode(dev_t dev, ino_t ino) {
+    uint64_t x = (uint64_t)ino ^ ((uint64_t)dev * 0x9E3779B97F4A7C15ULL);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief                Places a file in the first free slot from slot onwards.
+ *
+ * @param keys           The hash table.
+ * @param capacity       Amount of slots, a power of 2.
+ * @param slot           The slot to start at.
+ * @param key            The file.
+ */
+static void place_key(Inode_key *keys, size_t capacity, size_t slot, Inode_key key) {
+    while (keys[slot].used) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+    keys[slot] = key;
+}
+
+/**
+ * @brief                Doubles the hash table of a shard, and places every file again. The mutex of the shard
+ *                       has to be held.
+ *
+ * @param shard          The shard.
+ */
+static void grow_shard(Inode_set_shard *shard) {
+    size_t capacity = shard->capacity == 0 ? INODE_SET_START_CAPACITY : shard->capacity * 2;
+    Inode_key *keys = calloc(capacity, sizeof(Inode_key));
+    error_handler_null(keys, NULL, "inode set couldn't allocate memory", true);
+    for (size_t i = 0; i < shard->capacity; i++) {
+        if (shard->keys[i].used) {
+            place_key(keys, capacity, hash_inode(shard->keys[i].dev, shard->keys[i].ino) & (capacity - 1),
+                      shard->keys[i]);
+        }
+    }
+    free(shard->keys);
+    shard->keys = keys;
+    shard->capacity = capacity;
+}
@@ -0,0 +1,119 @@
+/**
+ * @defgroup inode_set_h inode_set
+ *
+ * @brief This datatype is a set of files, identified by their device and inode numbers, that several threads
+ * can add to at the same time.
+ *
+ * The set is split into INODE_SET_SHARDS shards by the hash of a file, each with it's own mutex, so threads
+ * adding different files seldom wait for each other. Every shard is a hash table with open addressing, which
+ * is doubled when it's half full.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 1.0
+ *
+ * @{
+ */
+
+#ifndef INODE_SET_H
+#define INODE_SET_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "error_handler.h"
+
+#define INODE_SET_SHARD_BITS 6
+#define INODE_SET_SHARDS (1 << INODE_SET_SHARD_BITS)
+#define INODE_SET_START_CAPACITY 64
+
+/**
+ * @brief                  A struct which is the structure for a file in the set.
+ *
+ * @elem dev               The device number of the file.
+ * @elem ino               The inode number of the file.
+ * @elem used              True if the slot holds a file.
+ */
+typedef struct inode_key {
+    dev_t dev;
+    ino_t ino;
+    bool used;
+} Inode_key;
+
+/**
+ * @brief                  A struct which is the structure for a shard of the set.
+ *
+ * @elem keys              The hash table, NULL until the first file is added.
+ * @elem amount            Amount of files in the shard.
+ * @elem capacity          Amount of slots in the hash table, a power of 2.
+ * @elem mutex             A variable for holding a mutex lock.
+ */
+typedef struct inode_set_shard {
+    Inode_key *keys;
+    size_t amount;
+    size_t capacity;
+    pthread_mutex_t mutex;
+} Inode_set_shard;
+
+/**
+ * @brief                  A struct which is the structure for the set.
+ *
+ * @elem shards            The shards of the set.
+ */
+typedef struct inode_set {
+    Inode_set_shard shards[INODE_SET_SHARDS];
+} Inode_set;
+
+
+/**
+ * @brief                Creates an empty set, and allocates memory for it.
+ *
+ * @return               Returns a set that has been dynamically allocated.
+ */
+Inode_set *create_inode_set(void);
+
+
+/**
+ * @brief                Adds a file to the set.
+ *
+ * @param set            The set.
+ * @param dev            The device number of the file.
+ * @param ino            The inode number of the file.
+ * @return               True if the file was added, false if it already was in the set.
+ */
+bool inode_set_insert(Inode_set *set, dev_t dev, ino_t ino);
+
+
+/**
+ * @brief                Gives every file in the set. No file can be added while they are collected.
+ *
+ * @param set            The set.
+ * @param amount         Where the amount of files is stored.
+ * @return               The files, dynamically allocated. NULL if the set is empty.
+ */
+Inode_key *inode_set_keys(Inode_set *set, size_t *amount);
+
+
+/**
+ * @brief                Removes every file from the set.
+ *
+ * @param set            The set.
+ */
+void inode_set_clear(Inode_set *set);
+
+
+/**
+ * @brief                Deallocates the set.
+ *
+ * @param set            The set that will be deallocated.
+ */
+void destroy_inode_set(Inode_set *set);
+
+#endif //INODE_SET_H
+
+/**
+ * @}
+ */
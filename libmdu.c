@@ -0,0 +1,2202 @@
+/**
+ * @brief A library for calculating the size of file trees with multiple threads, the same way as [du].
+ *
+ * The size is calculated with a threadpool, where every thread owns a worker with a deque of tasks.
+ * Each task is a directory. When a directory and all of the directories inside of it has been calculated,
+ * it's directory node is complete and the size is added to the parent.
+ *
+ * If one thread is used, the task is done in the calling thread.
+ *
+ * The directory nodes only holds the names of the directories. The entries of a directory are stat'ed and
+ * opened relative to the directory's file descriptor, so the system calls never needs the whole path, and a
+ * file tree can be deeper than PATH_MAX. The path is only put together for the callbacks and error messages,
+ * and for opening a directory that wasn't opened by the directory that found it.
+ * A directory is stat'ed once, by the directory that found it, and a directory that becomes a task is opened
+ * by it as well, as long as fewer than CARRY_FD_MAX tasks are waiting with an opened directory, and the file
+ * descriptor limit has room for them next to the directories that the threads hold open themselves.
+ *
+ * A directory that can't be opened because the file descriptors have run out isn't counted as unreadable. The
+ * waiting tasks close the directories they carry, and otherwise the thread waits for another task to be done
+ * before it opens it again. A directory processed inline is added as a task instead.
+ *
+ * Symbolic links are followed by stat'ing and opening the entries without AT_SYMLINK_NOFOLLOW and O_NOFOLLOW.
+ * When every link is followed, the device and inode numbers of every directory of a root are added to a set,
+ * and a directory that already is in it is left out, so a cycle ends and a directory that several links
+ * point to is only counted once.
+ *
+ * Roots that are inside of another root, or the same as an earlier one, are found by comparing their canonical
+ * paths. Every directory that is completed is compared with them by it's device and inode numbers, and the
+ * totals of a matching directory are the result of the root. A root that is calculated before the root it's
+ * inside of is completed as a whole when that root reaches it, without being read again.
+ *
+ * Histograms of the file sizes are counted by every worker in it's own array, without locking, and the arrays
+ * are added together after the threads of a root have been joined.
+ *
+ * The age buckets are part of the totals, so every task counts the entries it stats in it's own totals, and
+ * they are added up the tree together with the blocks. Owners, and the file types and extensions of the files,
+ * are counted by every worker in it's own map, and the maps are added together after the threads of a root
+ * have been joined, as the histograms.
+ *
+ * With sort_inodes, every entry of a directory is read before any of them is stat'ed, and they are stat'ed
+ * in the order of their inode numbers.
+ *
+ * When the deadline of a scan has passed, or the scan has been cancelled, the tasks that are left are still
+ * taken, but their directories aren't read. They are completed with only their own size and counted as
+ * unvisited, so every root is still completed with a lower bound of it's size.
+ *
+ * An estimate reads every directory entry, but only reads a random sample of the directories inside of a
+ * directory with more than ESTIMATE_MIN_DIRS of them. The directories that aren't picked are stat'ed, but never
+ * opened. Each directory is picked with a probability p in proportion to the size of it's directory file, so
+ * the few large directories, that holds most of a tree, are picked more often than the many small ones. It's
+ * totals are scaled by 1 / p when they are added to it's parent. The variance of the estimate is
+ * (1 - p) / p^2 * blocks^2 of every picked directory, plus it's own variance divided by p, the variance of a
+ * multi stage sample.
+ *
+ * With a checkpoint, every thread is paused between two tasks now and then, and the waiting tasks are written
+ * to the checkpoint file, together with the nodes above them. A cancelled scan, or one that has passed it's
+ * deadline, writes one last checkpoint before any directory is skipped. A scan that is resumed creates the
+ * nodes and tasks of the checkpoint again, and starts with them instead of the root.
+ *
+ * @author  Ludwig Fallström
+ * @since   2021-10-14
+ * @version 3.8
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <time.h>
+#include <math.h>
+#include "string.h"
+#include <dirent.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include "libmdu.h"
+#include "list.h"
+#include "dir_node.h"
+#include "t_queue.h"
+#include "error_handler.h"
+#include "affinity.h"
+#include "checkpoint.h"
+
+#define AUTO_INTERVAL_MS 100
+#define AUTO_HOLD_INTERVALS 5
+#define AUTO_MIN_GAIN 1.05
+#define INLINE_DIR_SIZE 4096
+#define INLINE_DEPTH_MAX 32
+#define CARRY_FD_MAX 256
+#define FD_RESERVE 4 //the checkpoint file, and the files that the callbacks open
+#define FD_PROBE_MAX 1024 //the open file descriptors are only counted when the limit is less than this above the need
+#define READER_START_AMOUNT 64
+#define ESTIMATE_MIN_DIRS 8
+
+void add_tasks(Worker *worker, List *tasks, int task_amount);
+void inject_task(Task_queue *t_queue, Task *task);
+void inject_tasks(Task_queue *t_queue, List *tasks);
+Task *take_task(Worker *worker);
+blkcnt_t get_block_size_mult(Task *task, Worker *worker);
+blkcnt_t get_block_size_inline(Task *task, Worker *worker, Dir_node *node, const char *absolute_path,
+                               int parent_fd, struct stat *absolute_path_buf);
+bool out_of_fds(int error);
+bool wait_for_fds(Task_queue *t_queue);
+int release_carried_fds(Task_queue *t_queue);
+int open_parent(Task_queue *t_queue, const Dir_node *node, const char *absolute_path, const char **name);
+DIR *open_dir_at(int parent_fd, const char *name, bool follow);
+bool follows_links(Task_queue *t_queue, int depth);
+int stat_entry(Task_queue *t_queue, int fd, const char *name, struct stat *buf, int depth);
+bool first_visit(Task_queue *t_queue, const struct stat *buf);
+DIR *open_dir_node(Task_queue *t_queue, Dir_node *node, const char *absolute_path);
+void carry_fds(Worker *worker, int fd, List *batch, int batch_amount);
+int carry_fd_budget(int thread_amount);
+int open_fds(int limit);
+double seconds_since(const struct timespec *start_time);
+bool scan_stopped(Task_queue *t_queue);
+bool reading_stopped(Task_queue *t_queue);
+void skip_dir(Worker *worker, Dir_node *node, const char *path);
+bool sample_dir(Worker *worker, double sample_rate);
+void scale_totals(Mdu_totals *totals, double sample_rate);
+bool queue_is_starving(Task_queue *t_queue);
+bool inline_dir(Task *task, struct stat *dir_buf, bool starving);
+void unreadable_dir(Worker *worker, Dir_node *node, const char *path, const struct stat *buf, int error,
+                    Mdu_totals *totals);
+void report_file(Worker *worker, Dir_node *parent, const char *path, const char *name, struct stat *path_buf,
+                 int depth);
+int size_bucket(off_t size);
+void age_entry(const Task_queue *t_queue, Mdu_totals *totals, const struct stat *buf);
+void count_entry(Worker *worker, Mdu_totals *totals, const struct stat *buf);
+void merge_owners(Task_queue *t_queue, Mdu_owner_table *table);
+void count_extension(Worker *worker, const char *name, const struct stat *buf);
+Mdu_file_type file_type(mode_t mode);
+void merge_extensions(Task_queue *t_queue, Mdu_extension_table *table);
+void merge_histograms(Task_queue *t_queue, Mdu_histogram *histogram);
+long next_dir_id(Worker *worker);
+void complete_dir(Worker *worker, Dir_node *node, const char *path, const Mdu_totals *totals, bool report);
+void *run_thread(Worker *worker);
+void run_task(Worker *worker, Task *task);
+void run_mult_thread(Task_queue *t_queue, const char *start_path, List *tasks);
+void pause_for_checkpoint(Task_queue *t_queue);
+void report_root(Task_queue *t_queue, const char *path, const Mdu_result *result);
+void find_shared_roots(Task_queue *t_queue, const char *const *roots, int root_amount);
+bool path_inside(const char *outer, const char *inner);
+void share_dir(Task_queue *t_queue, const struct stat *buf, const Mdu_totals *totals, double duration);
+const Shared_root *shared_dir(Task_queue *t_queue, const struct stat *buf);
+bool shared_result(Task_queue *t_queue, int index, Mdu_result *result);
+blkcnt_t shutdown_threads(Task *task, Worker *worker);
+blkcnt_t get_size_of_dir(Task *task, Worker *worker, Dir_node *node, const char *absolute_path,
+                         struct stat *absolute_path_buf, DIR *dir, Mdu_totals *totals);
+void kill_task_initializer(Task_queue *t_queue, blkcnt_t temp_block_size, bool queue_empty, int t_running);
+void spawn_threads(Task_queue *t_queue, pthread_t *threads, int *thread_spawned, int amount);
+void run_thread_controller(Task_queue *t_queue, pthread_t *threads, int *thread_spawned);
+void place_workers(Task_queue *t_queue);
+void *place_worker(void *placement);
+
+/**
+ * @brief                  A struct holding an entry of a directory, while the entries are sorted.
+ *
+ * @elem ino               The inode number of the entry.
+ * @elem name_offset       The offset of the name in the names of the reader.
+ * @elem type              The d_type of the entry.
+ * @elem sample_rate       The probability that an estimate reads the entry, if it's a directory.
+ * @elem has_stat          True if the entry has been stat'ed into the stats of the reader.
+ */
+typedef struct dir_entry {
+    ino_t ino;
+    size_t name_offset;
+    unsigned char type;
+    double sample_rate;
+    bool has_stat;
+} Dir_entry;
+
+/**
+ * @brief                  A struct holding a directory that is read, in the order of readdir() or sorted by
+ *                         inode number.
+ *
+ * @elem dir               The opened directory.
+ * @elem buffered          True if every entry has been read into entries.
+ * @elem entries           The entries, sorted by inode number if asked for. NULL if not buffered.
+ * @elem amount            Amount of entries.
+ * @elem next              The index of the next entry to give.
+ * @elem names             The names of the buffered entries, null terminated after each other.
+ * @elem stats             The struct stat of every buffered entry that has been stat'ed while the directories
+ *                         were weighed, at the same index as the entry. NULL if they weren't weighed.
+ */
+typedef struct dir_reader {
+    DIR *dir;
+    bool buffered;
+    Dir_entry *entries;
+    size_t amount;
+    size_t next;
+    char *names;
+    struct stat *stats;
+} Dir_reader;
+
+void open_reader(Dir_reader *reader, DIR *dir, bool buffered, bool sorted);
+void weigh_dirs(Task_queue *t_queue, int fd, Dir_reader *reader, int depth);
+const char *read_entry(Dir_reader *reader, unsigned char *type, double *sample_rate, const struct stat **buf);
+void close_reader(Dir_reader *reader);
+int compare_inodes(const void *entry, const void *other);
+
+/**
+ * @brief                  A struct holding a worker that is being placed on the NUMA node of a CPU.
+ *
+ * @elem t_queue           The task queue that the worker belongs to.
+ * @elem id                The id of the worker.
+ * @elem cpu               The CPU that the worker will be pinned to.
+ * @elem worker            The worker that was created on the node.
+ */
+typedef struct placement {
+    Task_queue *t_queue;
+    int id;
+    int cpu;
+    Worker *worker;
+} Placement;
+
+
+void mdu_default_options(Mdu_options *options) {
+    options->thread_amount = 1;
+    options->auto_threads = false;
+    options->pin_threads = false;
+    options->follow = MDU_FOLLOW_NONE;
+    options->share_roots = false;
+    options->sort_inodes = false;
+    options->deadline = 0;
+    options->sample_rate = 1;
+    options->cancel = NULL;
+    options->histograms = NULL;
+    options->owner_key = MDU_OWNER_NONE;
+    options->owners = NULL;
+    options->extensions = NULL;
+    options->age = MDU_AGE_NONE;
+    options->age_boundaries = NULL;
+    options->age_boundary_amount = 0;
+    options->checkpoint = NULL;
+    options->checkpoint_interval = 0;
+    options->resume = false;
+}
+
+
+int mdu_thread_amount(const Mdu_options *options) {
+    Mdu_options default_options;
+    if (options == NULL) {
+        mdu_default_options(&default_options);
+        options = &default_options;
+    }
+    int thread_amount = options->auto_threads ? AUTO_THREAD_MAX : options->thread_amount;
+    return thread_amount < 1 ? 1 : thread_amount;
+}
+
+
+bool mdu_scan(const char *const *roots, int root_amount, const Mdu_options *options,
+              Mdu_callback dir_callback, Mdu_callback file_callback, void *data, Mdu_result *results) {
+    Mdu_options default_options;
+    if (options == NULL) {
+        mdu_default_options(&default_options);
+        options = &default_options;
+    }
+    int thread_amount = mdu_thread_amount(options);
+
+    Task_queue *t_queue = create_task_queue(thread_amount, options->auto_threads);
+    if (options->pin_threads && thread_amount > 1) {
+        place_workers(t_queue);
+    }
+    t_queue->dir_callback = dir_callback;
+    t_queue->file_callback = file_callback;
+    t_queue->callback_data = data;
+    t_queue->sort_inodes = options->sort_inodes;
+    t_queue->follow = options->follow;
+    if (t_queue->follow == MDU_FOLLOW_ALL) {
+        t_queue->visited = create_inode_set();
+    } else if (options->share_roots && options->histograms == NULL && options->owner_key == MDU_OWNER_NONE
+               && options->extensions == NULL && root_amount > 1) {
+        find_shared_roots(t_queue, roots, root_amount);
+    }
+    t_queue->sample_rate = options->sample_rate > 0 && options->sample_rate < 1 ? options->sample_rate : 1;
+    if (t_queue->sample_rate < 1) {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        for (int i = 0; i < thread_amount; i++) {
+            t_queue->workers[i]->random_state ^= (unsigned long long)now.tv_sec * 1000000000ULL + now.tv_nsec;
+        }
+    }
+    if (options->deadline > 0) {
+        clock_gettime(CLOCK_MONOTONIC, &t_queue->deadline);
+        long nanoseconds = (long)((options->deadline - (long)options->deadline) * 1e9) + t_queue->deadline.tv_nsec;
+        t_queue->deadline.tv_sec += (time_t)options->deadline + nanoseconds / 1000000000L;
+        t_queue->deadline.tv_nsec = nanoseconds % 1000000000L;
+        t_queue->has_deadline = true;
+    }
+    t_queue->cancel = options->cancel;
+    t_queue->age = options->age;
+    t_queue->age_start = time(NULL);
+    for (int i = 0; options->age != MDU_AGE_NONE && i < options->age_boundary_amount && i < MDU_AGE_BUCKETS - 1;
+         i++) {
+        t_queue->age_boundaries[t_queue->age_boundary_amount++] = options->age_boundaries[i];
+    }
+    t_queue->owner_key = options->owner_key;
+    for (int i = 0; t_queue->owner_key != MDU_OWNER_NONE && i < thread_amount; i++) {
+        t_queue->workers[i]->owners = create_owner_map();
+    }
+    for (int i = 0; t_queue->owner_key != MDU_OWNER_NONE && i < root_amount; i++) {
+        options->owners[i] = (Mdu_owner_table) { .owners = NULL, .owner_amount = 0 };
+    }
+    for (int i = 0; options->extensions != NULL && i < thread_amount; i++) {
+        t_queue->workers[i]->extensions = create_extension_map();
+    }
+    for (int i = 0; options->extensions != NULL && i < root_amount; i++) {
+        options->extensions[i] = (Mdu_extension_table) { .extensions = NULL, .extension_amount = 0 };
+    }
+    for (int i = 0; options->histograms != NULL && i < thread_amount; i++) {
+        t_queue->workers[i]->histogram = calloc(1, sizeof(Mdu_histogram));
+        error_handler_null(t_queue->workers[i]->histogram, NULL, "Memory for a histogram couldn't be allocated",
+                           true);
+    }
+    int carry_budget = carry_fd_budget(thread_amount);
+    t_queue->carried_fd_max = carry_budget;
+
+    Checkpoint *checkpoint = NULL;
+    List *resumed = list_create();
+    int first_root = 0;
+    Mdu_error error = MDU_ERROR_NONE;
+    if (options->checkpoint != NULL) {
+        checkpoint = create_checkpoint(options->checkpoint, options->checkpoint_interval, roots, root_amount,
+                                       results);
+        t_queue->checkpoint = checkpoint;
+        if (options->resume) {
+            error = resume_checkpoint(checkpoint, t_queue, results,
+                                      (void (*)(struct task *, Worker *)) (void (*)(void)) get_block_size_mult,
+                                      resumed, &first_root);
+        }
+    }
+    //a scan that can't be resumed isn't started, the caller reports the error
+    if (error != MDU_ERROR_NONE) {
+        for (int i = 0; i < root_amount; i++) {
+            results[i] = (Mdu_result) { .permission = false, .error = error };
+        }
+        destroy_checkpoint(checkpoint);
+        list_destroy(resumed);
+        destroy_queue(t_queue);
+        return false;
+    }
+
+    bool permission = true;
+    //the roots that were done before the checkpoint are only reported
+    for (int i = 0; i < first_root; i++) {
+        report_root(t_queue, roots[i], &results[i]);
+        permission = permission && results[i].permission;
+    }
+    for (int i = first_root; i < root_amount; i++) {
+        if (checkpoint != NULL) {
+            checkpoint->root_index = i;
+        }
+        //a root that was completed in the scan of another root isn't read again
+        if (shared_result(t_queue, i, &results[i])) {
+            report_root(t_queue, roots[i], &results[i]);
+            permission = permission && results[i].permission;
+            continue;
+        }
+        run_mult_thread(t_queue, roots[i], resumed);
+        if (options->histograms != NULL) {
+            merge_histograms(t_queue, &options->histograms[i]);
+        }
+        if (t_queue->owner_key != MDU_OWNER_NONE) {
+            merge_owners(t_queue, &options->owners[i]);
+        }
+        if (options->extensions != NULL) {
+            merge_extensions(t_queue, &options->extensions[i]);
+        }
+        results[i].totals = t_queue->totals;
+        results[i].duration = t_queue->duration;
+        results[i].permission = t_queue->permission;
+        results[i].error = MDU_ERROR_NONE;
+        permission = permission && t_queue->permission;
+
+        //nulls the variables that has been changed
+        t_queue->totals = (Mdu_totals) { 0 };
+        t_queue->duration = 0;
+        t_queue->t_running = 0;
+        t_queue->entries = 0;
+        t_queue->carried_fds = 0;
+        t_queue->carried_fd_max = carry_budget;
+        t_queue->thread_limit = t_queue->auto_threads ? AUTO_THREAD_START : t_queue->thread_amount;
+        t_queue->permission = true;
+        t_queue->shutdown = false;
+        if (t_queue->visited != NULL) {
+            inode_set_clear(t_queue->visited);
+        }
+
+        //clears the queue
+        while (!queue_is_empty(t_queue)) {
+            kill_task(dequeue(t_queue));
+        }
+    }
+    if (checkpoint != NULL) {
+        destroy_checkpoint(checkpoint);
+    }
+    list_destroy(resumed);
+    destroy_queue(t_queue);
+    return permission;
+}
+
+
+/**
+ * @brief                                      The main algorithm for calculating the size of a task.
+ *
+ *                                             Calculates the size of the path of the task's directory node.
+ *                                             Only a root is stat'ed here, the other directories were stat'ed
+ *                                             by the directory that found them, and might have been opened by it.
+ *                                             If it's a file, the file size will be returned.
+ *                                             If it's a directory, the size of it's contents will be
+ *                                             returned. And the paths to directories will be added to
+ *                                             the worker's deque.
+ *                                             The totals are added to the directory node, which completes it if
+ *                                             there are no pending directories inside of it.
+ *                                             If an error occurred the permission is changed to false.
+ *
+ * @param task                                 A task containing a node that the size will be calculated upon.
+ * @param worker                               The worker running the task, new tasks are added to it's deque.
+ * @return                                     Returns the size of the path contained in the task.
+ */
+blkcnt_t get_block_size_mult(Task *task, Worker *worker) {
+    Task_queue *queue = worker->t_queue;
+    Dir_node *node = task->node;
+    Mdu_totals totals = { 0 };
+    //the path is only put together for the callbacks, or when the directory is looked up by it
+    char *absolute_path = NULL;
+    if (queue->dir_callback != NULL || queue->file_callback != NULL || !node->has_stat || node->fd < 0) {
+        absolute_path = dir_node_path(node);
+    }
+    if (!node->has_stat) {
+        int check = stat_entry(queue, AT_FDCWD, absolute_path, &node->stat, node->depth);
+        if (check < 0) {
+            totals.error_amount++;
+            complete_dir(worker, node, absolute_path, &totals, node->parent == NULL);
+            free(absolute_path);
+            return 0;
+        }
+        node->has_stat = true;
+        if (S_ISDIR(node->stat.st_mode)) {
+            first_visit(queue, &node->stat);
+        }
+    }
+    struct stat absolute_path_buf = node->stat;
+
+    if (S_ISDIR(absolute_path_buf.st_mode) && reading_stopped(queue)) {
+        skip_dir(worker, node, absolute_path);
+        free(absolute_path);
+        return absolute_path_buf.st_blocks;
+    }
+    //if dir
+    if (S_ISDIR(absolute_path_buf.st_mode)) {
+        //opens dir
+        DIR *dir = open_dir_node(queue, node, absolute_path);
+        int error = dir == NULL ? errno : 0;
+        while (dir == NULL && out_of_fds(error) && wait_for_fds(queue)) {
+            dir = open_dir_node(queue, node, absolute_path);
+            error = dir == NULL ? errno : 0;
+        }
+        if (dir == NULL) {
+            unreadable_dir(worker, node, absolute_path, &absolute_path_buf, error, &totals);
+        } else {
+            get_size_of_dir(task, worker, node, absolute_path, &absolute_path_buf, dir, &totals);
+        }
+        complete_dir(worker, node, absolute_path, &totals, true);
+    } else {
+        report_file(worker, node->parent, absolute_path, node->name, &absolute_path_buf, node->depth);
+        totals.block_size = absolute_path_buf.st_blocks;
+        totals.bytes = absolute_path_buf.st_size;
+        totals.file_amount = 1;
+        count_entry(worker, &totals, &absolute_path_buf);
+        complete_dir(worker, node, absolute_path, &totals, node->parent == NULL);
+    }
+    free(absolute_path);
+    return totals.block_size;
+}
+
+
+/**
+ * @brief                                      Calculates the size of a directory inside of the task that found it,
+ *                                             instead of adding a new task for it.
+ *
+ *                                             NOTE! That this function is in a recursive call chain
+ *
+ *                                             A directory that can't be opened because the file descriptors have
+ *                                             run out is left as it is, so that it can be added as a task.
+ *
+ * @param task                                 The task that found the directory.
+ * @param worker                               The worker running the task.
+ * @param node                                 The directory node of the directory.
+ * @param absolute_path                        The path to the directory. NULL if it isn't put together.
+ * @param parent_fd                            A file descriptor of the directory that the directory is inside of.
+ * @param absolute_path_buf                    A struct stat which holds information of the directory.
+ * @return                                     Returns the size of the directory. -1 if it wasn't opened, because
+ *                                             the file descriptors had run out.
+ */
+blkcnt_t get_block_size_inline(Task *task, Worker *worker, Dir_node *node, const char *absolute_path,
+                               int parent_fd, struct stat *absolute_path_buf) {
+    Mdu_totals totals = { 0 };
+    DIR *dir = open_dir_at(parent_fd, node->name, follows_links(worker->t_queue, node->depth));
+    if (dir == NULL && out_of_fds(errno)) {
+        return -1;
+    }
+    if (dir == NULL) {
+        unreadable_dir(worker, node, absolute_path, absolute_path_buf, errno, &totals);
+    } else {
+        task->inline_depth++;
+        get_size_of_dir(task, worker, node, absolute_path, absolute_path_buf, dir, &totals);
+        task->inline_depth--;
+    }
+    complete_dir(worker, node, absolute_path, &totals, true);
+    return totals.block_size;
+}
+
+
+/**
+ * @brief                                      Counts a directory that couldn't be opened with only it's own size,
+ *                                             and reports it to stderr. The path is put together for the message
+ *                                             if it hasn't been.
+ *
+ * @param worker                               The worker that tried to open the directory.
+ * @param node                                 The directory node of the directory.
+ * @param path                                 The path to the directory. NULL if it isn't put together.
+ * @param buf                                  The struct stat of the directory.
+ * @param error                                The errno of the open.
+ * @param totals                               Where the totals of the directory are stored.
+ */
+void unreadable_dir(Worker *worker, Dir_node *node, const char *path, const struct stat *buf, int error,
+                    Mdu_totals *totals) {
+    char *node_path = path == NULL ? dir_node_path(node) : NULL;
+    fprintf(stderr, "mdu: cannot read directory '%s': %s\n", path == NULL ? node_path : path, strerror(error));
+    free(node_path);
+    node->read_error = true;
+    pthread_mutex_lock(&worker->t_queue->mutex);
+    worker->t_queue->permission = false;
+    pthread_mutex_unlock(&worker->t_queue->mutex);
+    totals->block_size = buf->st_blocks;
+    totals->bytes = buf->st_size;
+    totals->dir_amount = 1;
+    totals->error_amount = 1;
+    count_entry(worker, totals, buf);
+}
+
+
+/**
+ * @brief                                      Opens the directory that a directory node is inside of, so that the
+ *                                             directory can be stat'ed and opened relative to it.
+ *
+ *                                             A path shorter than PATH_MAX is used as it is, relative to the
+ *                                             working directory. Otherwise the directories are opened one at a
+ *                                             time from the root, by their names. A directory on the way that has
+ *                                             been replaced by a symbolic link, or a file, isn't opened, unless
+ *                                             links at it's depth are followed.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param node                                 The directory node.
+ * @param absolute_path                        The path to the directory.
+ * @param name                                 Where the name to use relative to the returned file descriptor is
+ *                                             stored.
+ * @return                                     A file descriptor that has to be closed, or AT_FDCWD. -1 if some
+ *                                             directory on the way couldn't be opened, with errno set.
+ */
+int open_parent(Task_queue *t_queue, const Dir_node *node, const char *absolute_path, const char **name) {
+    if (node->parent == NULL || strlen(absolute_path) < PATH_MAX) {
+        *name = absolute_path;
+        return AT_FDCWD;
+    }
+    const Dir_node **ancestors = malloc(node->depth * sizeof(Dir_node *));
+    error_handler_null(ancestors, NULL, "Memory for the directories of a path couldn't be allocated", true);
+    const Dir_node *ancestor = node->parent;
+    for (int i = node->depth - 1; i >= 0; i--) {
+        ancestors[i] = ancestor;
+        ancestor = ancestor->parent;
+    }
+    int fd = AT_FDCWD;
+    for (int i = 0; i < node->depth; i++) {
+        int flags = follows_links(t_queue, ancestors[i]->depth) ? 0 : O_NOFOLLOW;
+        int next_fd = openat(fd, ancestors[i]->name, O_RDONLY | O_DIRECTORY | O_CLOEXEC | flags);
+        int error = errno;
+        if (fd >= 0) { close(fd); }
+        fd = next_fd;
+        if (fd < 0) {
+            errno = error;
+            break;
+        }
+    }
+    free(ancestors);
+    *name = node->name;
+    return fd;
+}
+
+
+/**
+ * @brief                                      Opens the directory of a directory node that is run as a task. The
+ *                                             file descriptor that the node carries is used if it has one.
+ *
+ *                                             A symbolic link is only opened if links at it's depth are followed.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param node                                 The directory node.
+ * @param absolute_path                        The path to the directory. Only used, and can only be NULL, if the
+ *                                             node carries a file descriptor.
+ * @return                                     The opened directory. NULL if it, or a directory on the way,
+ *                                             couldn't be opened, with errno set.
+ */
+DIR *open_dir_node(Task_queue *t_queue, Dir_node *node, const char *absolute_path) {
+    if (node->fd >= 0) {
+        DIR *dir = fdopendir(node->fd);
+        if (dir != NULL) {
+            node->fd = -1;
+        }
+        return dir;
+    }
+    const char *name;
+    int parent_fd = open_parent(t_queue, node, absolute_path, &name);
+    if (parent_fd == -1) {
+        return NULL;
+    }
+    DIR *dir = open_dir_at(parent_fd, name, follows_links(t_queue, node->depth));
+    int error = errno;
+    if (parent_fd >= 0) {
+        close(parent_fd);
+    }
+    errno = error;
+    return dir;
+}
+
+
+/**
+ * @brief                                      Opens the directories of a batch of new tasks, relative to the
+ *                                             directory that found them, so that they aren't looked up by their
+ *                                             paths again when they run.
+ *
+ *                                             At most carried_fd_max tasks are waiting with an opened directory,
+ *                                             so that a wide file tree doesn't run out of file descriptors. The rest
+ *                                             of the tasks opens their directories when they run.
+ *
+ * @param worker                               The worker running the task that found the directories.
+ * @param fd                                   A file descriptor of the directory that found them.
+ * @param batch                                The new tasks.
+ * @param batch_amount                         Amount of tasks in the batch.
+ */
+void carry_fds(Worker *worker, int fd, List *batch, int batch_amount) {
+    Task_queue *t_queue = worker->t_queue;
+    pthread_mutex_lock(&t_queue->mutex);
+    int amount = t_queue->carried_fd_max - t_queue->carried_fds;
+    amount = amount < batch_amount ? amount : batch_amount;
+    amount = amount < 0 ? 0 : amount;
+    t_queue->carried_fds += amount;
+    pthread_mutex_unlock(&t_queue->mutex);
+
+    int failed = 0;
+    ListPos pos = list_first(batch);
+    for (int i = 0; i < amount; i++) {
+        Task *task = list_inspect(pos);
+        int flags = follows_links(t_queue, task->node->depth) ? 0 : O_NOFOLLOW;
+        task->node->fd = openat(fd, task->node->name, O_RDONLY | O_DIRECTORY | O_CLOEXEC | flags);
+        task->carried_fd = task->node->fd >= 0;
+        failed += task->carried_fd ? 0 : 1;
+        pos = list_next(pos);
+    }
+    if (failed > 0) {
+        pthread_mutex_lock(&t_queue->mutex);
+        t_queue->carried_fds -= failed;
+        pthread_mutex_unlock(&t_queue->mutex);
+    }
+}
+
+
+/**
+ * @brief                                      Gives the most tasks that can wait with an opened directory at once.
+ *
+ *                                             The file descriptor limit has to have room for them next to the
+ *                                             descriptors that are open when the scan starts, FD_RESERVE more, and
+ *                                             the ones every thread holds itself, which are it's directory, the
+ *                                             directories processed inline inside of it, and the ones that
+ *                                             open_parent() opens on the way down a long path.
+ *
+ * @param thread_amount                        Amount of threads of the scan.
+ * @return                                     The most tasks that can carry a directory, 0 if none can.
+ */
+int carry_fd_budget(int thread_amount) {
+    struct rlimit fd_limit;
+    if (getrlimit(RLIMIT_NOFILE, &fd_limit) != 0 || fd_limit.rlim_cur == RLIM_INFINITY) {
+        return CARRY_FD_MAX;
+    }
+    long limit = (long)fd_limit.rlim_cur;
+    long held = (long)thread_amount * (INLINE_DEPTH_MAX + 2) + FD_RESERVE;
+    if (limit - held - CARRY_FD_MAX >= FD_PROBE_MAX) {
+        return CARRY_FD_MAX;
+    }
+    long budget = limit - held - open_fds((int)limit);
+    return budget < 0 ? 0 : (budget < CARRY_FD_MAX ? (int)budget : CARRY_FD_MAX);
+}
+
+
+/**
+ * @brief                                      Counts the file descriptors of the process that are open.
+ *
+ * @param limit                                The file descriptor limit, every descriptor is below it.
+ * @return                                     Amount of open file descriptors.
+ */
+int open_fds(int limit) {
+    int amount = 0;
+    for (int fd = 0; fd < limit; fd++) {
+        amount += fcntl(fd, F_GETFD) != -1 ? 1 : 0;
+    }
+    return amount;
+}
+
+
+/**
+ * @brief                                      Checks if an open failed because the process, or the system, had run
+ *                                             out of file descriptors, which doesn't make a directory unreadable.
+ *
+ * @param error                                The errno of the open.
+ * @return                                     True if the file descriptors had run out.
+ */
+bool out_of_fds(int error) {
+    return error == EMFILE || error == ENFILE;
+}
+
+
+/**
+ * @brief                                      Frees file descriptors, after a directory couldn't be opened because
+ *                                             they had run out.
+ *
+ *                                             The directories that the waiting tasks carry are closed first.
+ *                                             Otherwise the thread waits until another task is done, which closes
+ *                                             the directories it had opened, as long as there is another running
+ *                                             task that isn't waiting as well.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @return                                     True if the directory should be opened again. False if nothing in
+ *                                             the scan can free a file descriptor.
+ */
+bool wait_for_fds(Task_queue *t_queue) {
+    if (release_carried_fds(t_queue) > 0) {
+        return true;
+    }
+    pthread_mutex_lock(&t_queue->mutex);
+    long tasks_done = t_queue->tasks_done;
+    t_queue->fd_waiting++;
+    //the threads that already wait might have been waiting for this one
+    pthread_cond_broadcast(&t_queue->fd_cond);
+    while (tasks_done == t_queue->tasks_done && t_queue->t_running > t_queue->fd_waiting) {
+        int check_wait = pthread_cond_wait(&t_queue->fd_cond, &t_queue->mutex);
+        error_handler_value(0, check_wait, NULL, "Error! cond_wait failed\n",
+                            false);
+    }
+    t_queue->fd_waiting--;
+    bool freed = tasks_done != t_queue->tasks_done;
+    pthread_mutex_unlock(&t_queue->mutex);
+    return freed;
+}
+
+
+/**
+ * @brief                                      Closes the directories that the waiting tasks carry, so they are
+ *                                             opened by their paths when they run, and halves the amount of tasks
+ *                                             that can carry one.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @return                                     Amount of directories that were closed.
+ */
+int release_carried_fds(Task_queue *t_queue) {
+    int released = 0;
+    for (int i = 0; i < t_queue->thread_amount; i++) {
+        Worker *worker = t_queue->workers[i];
+        pthread_mutex_lock(&worker->mutex);
+        for (ListPos pos = list_first(worker->deque); !list_pos_equal(pos, list_end(worker->deque));
+             pos = list_next(pos)) {
+            Task *task = list_inspect(pos);
+            if (task->carried_fd) {
+                close(task->node->fd);
+                task->node->fd = -1;
+                task->carried_fd = false;
+                released++;
+            }
+        }
+        pthread_mutex_unlock(&worker->mutex);
+    }
+    pthread_mutex_lock(&t_queue->mutex);
+    t_queue->carried_fds -= released;
+    t_queue->carried_fd_max /= 2;
+    pthread_mutex_unlock(&t_queue->mutex);
+    return released;
+}
+
+
+/**
+ * @brief                                      Opens a directory relative to the directory of a file descriptor.
+ *                                             A symbolic link is only followed if asked for.
+ *
+ * @param parent_fd                            A file descriptor of a directory, or AT_FDCWD.
+ * @param name                                 The name of the directory, or a path relative to parent_fd.
+ * @param follow                               True if the directory is opened if it's a symbolic link.
+ * @return                                     The opened directory. NULL if it couldn't be opened, with errno set.
+ */
+DIR *open_dir_at(int parent_fd, const char *name, bool follow) {
+    int fd = openat(parent_fd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC | (follow ? 0 : O_NOFOLLOW));
+    if (fd < 0) {
+        return NULL;
+    }
+    DIR *dir = fdopendir(fd);
+    if (dir == NULL) {
+        int error = errno;
+        close(fd);
+        errno = error;
+    }
+    return dir;
+}
+
+
+/**
+ * @brief                                      Checks if the symbolic links at a depth of the file tree are followed.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param depth                                How many directories below the root the entry is.
+ * @return                                     True if a link at the depth is followed.
+ */
+bool follows_links(Task_queue *t_queue, int depth) {
+    return t_queue->follow == MDU_FOLLOW_ALL || (depth == 0 && t_queue->follow == MDU_FOLLOW_ROOTS);
+}
+
+
+/**
+ * @brief                                      Stat's an entry relative to the directory of a file descriptor. A
+ *                                             symbolic link is followed if links at the depth are, and a link that
+ *                                             doesn't point to anything is stat'ed as the link itself.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param fd                                   A file descriptor of a directory, or AT_FDCWD.
+ * @param name                                 The name of the entry, or a path relative to fd.
+ * @param buf                                  Where the struct stat is stored.
+ * @param depth                                How many directories below the root the entry is.
+ * @return                                     0 if the entry was stat'ed, otherwise -1.
+ */
+int stat_entry(Task_queue *t_queue, int fd, const char *name, struct stat *buf, int depth) {
+    if (follows_links(t_queue, depth) && fstatat(fd, name, buf, 0) == 0) {
+        return 0;
+    }
+    return fstatat(fd, name, buf, AT_SYMLINK_NOFOLLOW);
+}
+
+
+/**
+ * @brief                                      Adds a directory to the directories that have been reached, when
+ *                                             every link is followed.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param buf                                  The struct stat of the directory.
+ * @return                                     False if the directory already had been reached.
+ */
+bool first_visit(Task_queue *t_queue, const struct stat *buf) {
+    return t_queue->visited == NULL || inode_set_insert(t_queue->visited, buf->st_dev, buf->st_ino);
+}
+
+
+/**
+ * @brief                                      Checks if the threadpool is starving, which is when there are no
+ *                                             tasks left to take, and threads allowed to take tasks are idle.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @return                                     True if the threadpool is starving.
+ */
+bool queue_is_starving(Task_queue *t_queue) {
+    pthread_mutex_lock(&t_queue->mutex);
+    bool starving = (waiting_tasks(t_queue) == 0) && (t_queue->t_running < t_queue->thread_limit);
+    pthread_mutex_unlock(&t_queue->mutex);
+    return starving;
+}
+
+
+/**
+ * @brief                                      Decides if a directory should be processed inline by the task that
+ *                                             found it, instead of being added as a new task.
+ *
+ *                                             Small directories (the directory file itself is at most
+ *                                             INLINE_DIR_SIZE bytes) are processed inline, as long as the threadpool
+ *                                             isn't starving for tasks and the inline recursion isn't deeper than
+ *                                             INLINE_DEPTH_MAX.
+ *
+ * @param task                                 The task that found the directory.
+ * @param dir_buf                              A struct stat which holds information of the directory.
+ * @param starving                             True if the threadpool was starving when the parent was opened.
+ * @return                                     True if the directory should be processed inline.
+ */
+bool inline_dir(Task *task, struct stat *dir_buf, bool starving) {
+    return !starving && (dir_buf->st_size <= INLINE_DIR_SIZE) && (task->inline_depth < INLINE_DEPTH_MAX);
+}
+
+
+/**
+ * @brief                                      The main algorithm for going through a directory and calculating it's
+ *                                             contents total size.
+ *
+ *                                             In multithreading mode, tasks will be added to the worker's deque, if
+ *                                             new directories inside is found. The tasks are collected in a batch
+ *                                             that is added when the whole directory has been read. Small
+ *                                             directories are processed inline instead, unless the threadpool is
+ *                                             starving for tasks. Every directory found gets a directory node.
+ *                                             The entries are sorted by inode number first, if sort_inodes is
+ *                                             set, so the directories are added in that order as well.
+ *
+ *                                             The totals of the directories inside isn't included, they are added
+ *                                             through their directory nodes when they complete.
+ *
+ * @param task                                 A task containing a function pointer, which will be used to create
+ *                                             a new task.
+ * @param worker                               The worker running the task.
+ * @param node                                 The directory node of the directory.
+ * @param absolute_path                        The path to the directory, which the new path names are made from.
+ *                                             NULL if the paths aren't put together.
+ * @param absolute_path_buf                    A struct stat which holds information of the directory.
+ * @param dir                                  A pointer to an opened directory.
+ * @param totals                               The totals that the directory, and the files directly inside of it,
+ *                                             are added upon.
+ * @return                                     Returns the size of the directory, and the files directly inside.
+ */
+blkcnt_t get_size_of_dir(Task *task, Worker *worker, Dir_node *node, const char *absolute_path,
+                         struct stat *absolute_path_buf, DIR *dir, Mdu_totals *totals) {
+    const char *name;
+    unsigned char type;
+    double sample_rate;
+    const struct stat *weighed_buf;
+    Dir_reader reader;
+    Task_queue *t_queue = worker->t_queue;
+    int fd = dirfd(dir);
+    open_reader(&reader, dir, t_queue->sort_inodes || t_queue->sample_rate < 1, t_queue->sort_inodes);
+    weigh_dirs(t_queue, fd, &reader, node->depth + 1);
+    bool starving = queue_is_starving(worker->t_queue);
+    List *batch = NULL;
+    int batch_amount = 0;
+    //one buffer holds the path of every entry, the path of the directory is copied once
+    size_t prefix_length = 0;
+    char *new_absolute_path = NULL;
+    if (absolute_path != NULL) {
+        prefix_length = strlen(absolute_path);
+        new_absolute_path = malloc(prefix_length + NAME_MAX + 2);
+        error_handler_null(new_absolute_path, NULL, "Memory for new path couldn't be allocated",
+                           true);
+        memcpy(new_absolute_path, absolute_path, prefix_length);
+        if (prefix_length == 0 || absolute_path[prefix_length - 1] != '/') {
+            new_absolute_path[prefix_length++] = '/';
+        }
+    }
+    //if directory has content
+    while ((name = read_entry(&reader, &type, &sample_rate, &weighed_buf)) != NULL) {
+        task->entries++;
+        //when estimating, a directory that isn't picked is left out
+        if (sample_rate < 1 && !sample_dir(worker, sample_rate)) {
+            continue;
+        }
+        if (new_absolute_path != NULL) {
+            strcpy(&new_absolute_path[prefix_length], name);
+        }
+
+        //an entry that was stat'ed when the directories were weighed isn't stat'ed again
+        struct stat new_absolute_path_buf;
+        int check = 0;
+        if (weighed_buf != NULL) {
+            new_absolute_path_buf = *weighed_buf;
+        } else {
+            check = stat_entry(t_queue, fd, name, &new_absolute_path_buf, node->depth + 1);
+        }
+
+        //if path is not readable, size of current directory is added
+        if ((check < 0)) {
+            totals->block_size += (*absolute_path_buf).st_blocks;
+            totals->error_amount++;
+            break;
+        }
+        else if (strcmp(name, ".") == 0) {
+            totals->block_size += new_absolute_path_buf.st_blocks;
+            totals->bytes += new_absolute_path_buf.st_size;
+            totals->dir_amount++;
+            count_entry(worker, totals, &new_absolute_path_buf);
+        }
+        else if (strcmp(name, "..") != 0) {
+            //if path is a file, or anything else that isn't a directory
+            if (!S_ISDIR(new_absolute_path_buf.st_mode)) {
+                report_file(worker, node, new_absolute_path, name, &new_absolute_path_buf, node->depth + 1);
+                totals->block_size += new_absolute_path_buf.st_blocks;
+                totals->bytes += new_absolute_path_buf.st_size;
+                totals->file_amount++;
+                count_entry(worker, totals, &new_absolute_path_buf);
+            }
+            //if path is a directory, that hasn't been reached before through a link or a cycle
+            else if (first_visit(t_queue, &new_absolute_path_buf)) {
+                Dir_node *new_node = create_dir_node(node, name, next_dir_id(worker));
+                new_node->stat = new_absolute_path_buf;
+                new_node->has_stat = true;
+                new_node->sample_rate = sample_rate;
+                const Shared_root *shared = shared_dir(t_queue, &new_absolute_path_buf);
+                //a root that has been calculated already is completed with it's result
+                if (shared != NULL) {
+                    complete_dir(worker, new_node, new_absolute_path, &shared->result.totals, true);
+                }
+                //after the deadline, or when cancelled, the directory isn't read at all
+                else if (reading_stopped(worker->t_queue)) {
+                    skip_dir(worker, new_node, new_absolute_path);
+                }
+                //small directories are processed by this task, the others are added to the task queue, as are
+                //the small ones that couldn't be opened because the file descriptors had run out
+                else if (!inline_dir(task, &new_absolute_path_buf, starving)
+                         || get_block_size_inline(task, worker, new_node, new_absolute_path, fd,
+                                                  &new_absolute_path_buf) < 0) {
+                    Task *new_task = create_task(new_node, (void (*)(struct task *,
+                            Worker *)) (void (*)(void)) task->task_pointer);
+                    if (batch == NULL) {
+                        batch = list_create();
+                    }
+                    list_insert(list_end(batch), new_task);
+                    batch_amount++;
+                }
+            }
+        }
+    }
+    free(new_absolute_path);
+    close_reader(&reader);
+
+    //publishes the directories that was found, opened while the directory still is
+    if (batch != NULL) {
+        carry_fds(worker, fd, batch, batch_amount);
+        add_tasks(worker, batch, batch_amount);
+        list_destroy(batch);
+    }
+    error_handler_value(0, closedir(dir), "Couldn't close directory\n",
+                        NULL, false);
+    return totals->block_size;
+}
+
+/**
+ * @brief                                      Starts reading a directory. If the entries should be buffered, every
+ *                                             entry is read here, and sorted by inode number if asked for.
+ *
+ * @param reader                               The reader that is started.
+ * @param dir                                  The opened directory. It's closed by the caller.
+ * @param buffered                             True if every entry should be read before the first is given.
+ * @param sorted                               True if the entries should be sorted. Implies buffered.
+ */
+void open_reader(Dir_reader *reader, DIR *dir, bool buffered, bool sorted) {
+    *reader = (Dir_reader) { .dir = dir, .buffered = buffered || sorted, .entries = NULL, .amount = 0,
+                             .next = 0, .names = NULL, .stats = NULL };
+    if (!reader->buffered) {
+        return;
+    }
+    size_t capacity = READER_START_AMOUNT;
+    size_t names_capacity = READER_START_AMOUNT * 16;
+    size_t names_length = 0;
+    reader->entries = malloc(capacity * sizeof(Dir_entry));
+    reader->names = malloc(names_capacity);
+    error_handler_null(reader->entries, NULL, "Memory for directory entries couldn't be allocated", true);
+    error_handler_null(reader->names, NULL, "Memory for directory entries couldn't be allocated", true);
+
+    struct dirent *dir_struct;
+    while ((dir_struct = readdir(dir)) != NULL) {
+        size_t length = strlen(dir_struct->d_name) + 1;
+        if (reader->amount == capacity) {
+            capacity *= 2;
+            reader->entries = realloc(reader->entries, capacity * sizeof(Dir_entry));
+            error_handler_null(reader->entries, NULL, "Memory for directory entries couldn't be allocated", true);
+        }
+        if (names_length + length > names_capacity) {
+            names_capacity = names_capacity * 2 > names_length + length ? names_capacity * 2
+                                                                        : names_length + length;
+            reader->names = realloc(reader->names, names_capacity);
+            error_handler_null(reader->names, NULL, "Memory for directory entries couldn't be allocated", true);
+        }
+        memcpy(&reader->names[names_length], dir_struct->d_name, length);
+        reader->entries[reader->amount].ino = dir_struct->d_ino;
+        reader->entries[reader->amount].type = dir_struct->d_type;
+        reader->entries[reader->amount].name_offset = names_length;
+        reader->entries[reader->amount].sample_rate = 1;
+        reader->entries[reader->amount].has_stat = false;
+        reader->amount++;
+        names_length += length;
+    }
+    if (sorted) {
+        qsort(reader->entries, reader->amount, sizeof(Dir_entry), compare_inodes);
+    }
+}
+
+
+/**
+ * @brief                                      Gives the name of the next entry of a directory.
+ *
+ * @param reader                               The reader of the directory.
+ * @param type                                 Where the d_type of the entry is stored, DT_UNKNOWN if the file
+ *                                             system doesn't tell.
+ * @param sample_rate                          Where the probability that an estimate reads the entry is stored.
+ * @param buf                                  Where the struct stat of the entry is stored, if it was stat'ed
+ *                                             while the directories were weighed. NULL otherwise.
+ * @return                                     The name. NULL if there are no entries left.
+ */
+const char *read_entry(Dir_reader *reader, unsigned char *type, double *sample_rate, const struct stat **buf) {
+    *buf = NULL;
+    if (!reader->buffered) {
+        struct dirent *dir_struct = readdir(reader->dir);
+        if (dir_struct == NULL) {
+            return NULL;
+        }
+        *type = dir_struct->d_type;
+        *sample_rate = 1;
+        return dir_struct->d_name;
+    }
+    if (reader->next == reader->amount) {
+        return NULL;
+    }
+    const Dir_entry *entry = &reader->entries[reader->next];
+    if (entry->has_stat) {
+        *buf = &reader->stats[reader->next];
+    }
+    *type = entry->type;
+    *sample_rate = entry->sample_rate;
+    reader->next++;
+    return &reader->names[entry->name_offset];
+}
+
+
+/**
+ * @brief                                      Deallocates the sorted entries of a reader. The directory isn't
+ *                                             closed.
+ *
+ * @param reader                               The reader.
+ */
+void close_reader(Dir_reader *reader) {
+    free(reader->entries);
+    free(reader->names);
+    free(reader->stats);
+}
+
+
+/**
+ * @brief                                      Compares two directory entries by their inode numbers, for qsort.
+ *
+ * @param entry                                The first entry.
+ * @param other                                The second entry.
+ * @return                                     Less than, equal to or greater than 0, as the inode number of
+ *                                             entry is less than, equal to or greater than the one of other.
+ */
+int compare_inodes(const void *entry, const void *other) {
+    ino_t ino = ((const Dir_entry *)entry)->ino;
+    ino_t other_ino = ((const Dir_entry *)other)->ino;
+    return (ino > other_ino) - (ino < other_ino);
+}
+
+
+/**
+ * @brief                                      Gives a file, or anything else that isn't a directory, to the file
+ *                                             callback of the scan. A regular file is counted in the worker's
+ *                                             histogram, and every file for it's type and extension, if they are
+ *                                             collected.
+ *
+ * @param worker                               The worker that found the file.
+ * @param parent                               The node of the directory that the file is inside of. NULL if the
+ *                                             file is a root.
+ * @param path                                 The path to the file. Can be NULL if there is no file callback.
+ * @param name                                 The name of the file, or the path of a root.
+ * @param path_buf                             A struct stat which holds information of the file.
+ * @param depth                                How many directories below the root the file is.
+ */
+void report_file(Worker *worker, Dir_node *parent, const char *path, const char *name, struct stat *path_buf,
+                 int depth) {
+    Task_queue *t_queue = worker->t_queue;
+    if (worker->histogram != NULL && S_ISREG(path_buf->st_mode)) {
+        int bucket = size_bucket(path_buf->st_size);
+        worker->histogram->file_amount[bucket]++;
+        worker->histogram->block_size[bucket] += path_buf->st_blocks;
+    }
+    if (worker->extensions != NULL) {
+        count_extension(worker, name, path_buf);
+    }
+    if (t_queue->file_callback != NULL) {
+        Mdu_entry entry = { .path = path, .stat = path_buf, .id = 0, .parent_id = parent == NULL ? 0 : parent->id,
+                            .read_error = false, .depth = depth, .worker = worker->id,
+                            .duration = seconds_since(&t_queue->start_time) };
+        entry.totals.block_size = path_buf->st_blocks;
+        entry.totals.bytes = path_buf->st_size;
+        entry.totals.file_amount = 1;
+        age_entry(t_queue, &entry.totals, path_buf);
+        t_queue->file_callback(&entry, t_queue->callback_data);
+    }
+}
+
+
+/**
+ * @brief                                      Gives the bucket of a histogram that a file size belongs to, which is
+ *                                             the amount of bits that are needed for the size.
+ *
+ * @param size                                 The size in bytes.
+ * @return                                     The bucket, 0 for an empty file.
+ */
+int size_bucket(off_t size) {
+    if (size <= 0) {
+        return 0;
+    }
+    int bucket = 64 - __builtin_clzll((unsigned long long)size);
+    return bucket < MDU_HISTOGRAM_BUCKETS ? bucket : MDU_HISTOGRAM_BUCKETS - 1;
+}
+
+
+/**
+ * @brief                                      Adds the blocks of an entry to it's age bucket in the totals, if ages
+ *                                             are collected. An entry from the future is counted as the youngest.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param totals                               The totals that the entry is counted in.
+ * @param buf                                  The struct stat of the entry.
+ */
+void age_entry(const Task_queue *t_queue, Mdu_totals *totals, const struct stat *buf) {
+    if (t_queue->age == MDU_AGE_NONE) {
+        return;
+    }
+    double age = difftime(t_queue->age_start, t_queue->age == MDU_AGE_ATIME ? buf->st_atime : buf->st_mtime);
+    int bucket = 0;
+    while (bucket < t_queue->age_boundary_amount && age >= t_queue->age_boundaries[bucket]) {
+        bucket++;
+    }
+    totals->age_block_size[bucket] += buf->st_blocks;
+}
+
+
+/**
+ * @brief                                      Counts an entry that has been stat'ed in the age buckets of the
+ *                                             totals, and for it's owner in the map of the worker, when they are
+ *                                             collected.
+ *
+ * @param worker                               The worker that stat'ed the entry.
+ * @param totals                               The totals that the entry is counted in.
+ * @param buf                                  The struct stat of the entry.
+ */
+void count_entry(Worker *worker, Mdu_totals *totals, const struct stat *buf) {
+    Task_queue *t_queue = worker->t_queue;
+    age_entry(t_queue, totals, buf);
+    if (t_queue->owner_key != MDU_OWNER_NONE) {
+        owner_map_add(worker->owners, t_queue->owner_key == MDU_OWNER_UID ? buf->st_uid : buf->st_gid,
+                      S_ISDIR(buf->st_mode) ? 0 : 1, buf->st_blocks);
+    }
+}
+
+
+/**
+ * @brief                                      Adds the owner maps of every worker to the owners of a root, and
+ *                                             empties them for the next root. The threads have to be joined.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param table                                The owners of the root.
+ */
+void merge_owners(Task_queue *t_queue, Mdu_owner_table *table) {
+    Owner_map *owners = create_owner_map();
+    for (int i = 0; i < t_queue->thread_amount; i++) {
+        owner_map_merge(owners, t_queue->workers[i]->owners);
+        owner_map_clear(t_queue->workers[i]->owners);
+    }
+    table->owners = owner_map_sorted(owners);
+    table->owner_amount = (long)owners->amount;
+    destroy_owner_map(owners);
+}
+
+
+/**
+ * @brief                                      Counts a file for it's type and extension in the map of the worker.
+ *
+ * @param worker                               The worker that found the file.
+ * @param name                                 The name of the file, or a path to it.
+ * @param buf                                  The struct stat of the file.
+ */
+void count_extension(Worker *worker, const char *name, const struct stat *buf) {
+    const char *slash = strrchr(name, '/');
+    name = slash != NULL ? slash + 1 : name;
+    const char *dot = strrchr(name, '.');
+    size_t length = 0;
+    //a name that starts with it's only '.' is hidden, and has no extension
+    if (dot != NULL && dot != name) {
+        length = strlen(dot + 1);
+    }
+    if (length > MDU_EXTENSION_MAX) {
+        length = 0;
+    }
+    extension_map_add(worker->extensions, file_type(buf->st_mode), length > 0 ? dot + 1 : "", length, 1,
+                      buf->st_blocks);
+}
+
+
+/**
+ * @brief                                      Gives the file type of the mode of a file.
+ *
+ * @param mode                                 The st_mode of the file.
+ * @return                                     The file type.
+ */
+Mdu_file_type file_type(mode_t mode) {
+    if (S_ISREG(mode)) {
+        return MDU_TYPE_REGULAR;
+    } else if (S_ISLNK(mode)) {
+        return MDU_TYPE_SYMLINK;
+    } else if (S_ISSOCK(mode)) {
+        return MDU_TYPE_SOCKET;
+    } else if (S_ISFIFO(mode)) {
+        return MDU_TYPE_FIFO;
+    } else if (S_ISCHR(mode) || S_ISBLK(mode)) {
+        return MDU_TYPE_DEVICE;
+    }
+    return MDU_TYPE_OTHER;
+}
+
+
+/**
+ * @brief                                      Adds the extension maps of every worker to the file types and
+ *                                             extensions of a root, and empties them for the next root. The
+ *                                             threads have to be joined.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param table                                The file types and extensions of the root.
+ */
+void merge_extensions(Task_queue *t_queue, Mdu_extension_table *table) {
+    Extension_map *extensions = create_extension_map();
+    for (int i = 0; i < t_queue->thread_amount; i++) {
+        extension_map_merge(extensions, t_queue->workers[i]->extensions);
+        extension_map_clear(t_queue->workers[i]->extensions);
+    }
+    table->extensions = extension_map_sorted(extensions);
+    table->extension_amount = (long)extensions->amount;
+    destroy_extension_map(extensions);
+}
+
+
+/**
+ * @brief                                      Adds the histograms of every worker to the histogram of a root, and
+ *                                             empties them for the next root. The threads have to be joined.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param histogram                            The histogram of the root.
+ */
+void merge_histograms(Task_queue *t_queue, Mdu_histogram *histogram) {
+    *histogram = (Mdu_histogram) { 0 };
+    for (int i = 0; i < t_queue->thread_amount; i++) {
+        Mdu_histogram *own = t_queue->workers[i]->histogram;
+        for (int j = 0; j < MDU_HISTOGRAM_BUCKETS; j++) {
+            histogram->file_amount[j] += own->file_amount[j];
+            histogram->block_size[j] += own->block_size[j];
+        }
+        *own = (Mdu_histogram) { 0 };
+    }
+}
+
+
+/**
+ * @brief                                      Gives an id for a new directory node. The ids of a worker are
+ *                                             spaced by the amount of threads, so they never collide with the
+ *                                             ids of the other workers, and are never 0.
+ *
+ * @param worker                               The worker creating the directory node.
+ * @return                                     The id.
+ */
+long next_dir_id(Worker *worker) {
+    worker->dir_amount++;
+    return worker->dir_amount * worker->t_queue->thread_amount + worker->id;
+}
+
+
+/**
+ * @brief                                      Gives the seconds that has passed since a point in time.
+ *
+ * @param start_time                           The point in time, from CLOCK_MONOTONIC.
+ * @return                                     The seconds since start_time.
+ */
+double seconds_since(const struct timespec *start_time) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start_time->tv_sec) + (double)(now.tv_nsec - start_time->tv_nsec) / 1e9;
+}
+
+
+/**
+ * @brief                                      Checks if the scan has been cancelled, or it's deadline has passed.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @return                                     True if the scan is cancelled, or has a deadline that has passed.
+ */
+bool scan_stopped(Task_queue *t_queue) {
+    //the flag is set by a signal handler, which can run on any thread
+    if (t_queue->cancel != NULL && __atomic_load_n(t_queue->cancel, __ATOMIC_RELAXED)) {
+        return true;
+    }
+    if (!t_queue->has_deadline) {
+        return false;
+    }
+    return seconds_since(&t_queue->deadline) >= 0;
+}
+
+
+/**
+ * @brief                                      Checks if directories should stop being read, because the scan has
+ *                                             stopped. With a checkpoint, they are read until the checkpoint of the
+ *                                             stopped scan has been written, so that no directory is left out of it.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @return                                     True if directories should be skipped.
+ */
+bool reading_stopped(Task_queue *t_queue) {
+    if (t_queue->checkpoint != NULL && !t_queue->checkpoint->stopped) {
+        return false;
+    }
+    return scan_stopped(t_queue);
+}
+
+
+/**
+ * @brief                                      Completes a directory that isn't read because the deadline has
+ *                                             passed, or the scan is cancelled. Only the size of the directory
+ *                                             itself is counted, and it's counted as unvisited.
+ *
+ * @param worker                               The worker that reached the directory.
+ * @param node                                 The directory node, which has been stat'ed.
+ * @param path                                 The path to the directory.
+ */
+void skip_dir(Worker *worker, Dir_node *node, const char *path) {
+    Mdu_totals totals = { .block_size = node->stat.st_blocks, .bytes = node->stat.st_size, .dir_amount = 1,
+                          .unvisited_amount = 1 };
+    count_entry(worker, &totals, &node->stat);
+    complete_dir(worker, node, path, &totals, true);
+}
+
+
+/**
+ * @brief                                      Gives every directory inside of a directory the probability that an
+ *                                             estimate picks it, in proportion to the size of it's directory
+ *                                             file, which grows with the amount of entries in it. A directory that
+ *                                             would get a probability of 1 or more is always picked, and the others
+ *                                             share the rest. About sample_rate of the directories are picked, but
+ *                                             at least ESTIMATE_MIN_DIRS, and all of them if there aren't more.
+ *
+ *                                             The directories are stat'ed for their sizes, and so are the entries
+ *                                             that readdir() doesn't tell the type of, and the links when every link
+ *                                             is followed. Their struct stat is kept in the reader, so they aren't
+ *                                             stat'ed again when they are read.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param fd                                   The file descriptor of the directory.
+ * @param reader                               The buffered reader of the directory.
+ * @param depth                                The depth of the entries below their root.
+ */
+void weigh_dirs(Task_queue *t_queue, int fd, Dir_reader *reader, int depth) {
+    if (t_queue->sample_rate == 1) {
+        return;
+    }
+    double *weights = malloc(reader->amount * sizeof(double));
+    error_handler_null(weights, NULL, "Memory for directory weights couldn't be allocated", true);
+    reader->stats = malloc((reader->amount > 0 ? reader->amount : 1) * sizeof(struct stat));
+    error_handler_null(reader->stats, NULL, "Memory for directory entries couldn't be allocated", true);
+    size_t dir_amount = 0;
+    double total_weight = 0;
+    for (size_t i = 0; i < reader->amount; i++) {
+        Dir_entry *entry = &reader->entries[i];
+        const char *name = &reader->names[entry->name_offset];
+        weights[i] = 0;
+        bool link = entry->type == DT_LNK && t_queue->follow == MDU_FOLLOW_ALL;
+        if ((entry->type != DT_DIR && entry->type != DT_UNKNOWN && !link) || strcmp(name, ".") == 0
+            || strcmp(name, "..") == 0) {
+            continue;
+        }
+        //an entry that can't be stat'ed is always read, so the error is counted
+        struct stat *buf = &reader->stats[i];
+        if (stat_entry(t_queue, fd, name, buf, depth) < 0) {
+            continue;
+        }
+        entry->has_stat = true;
+        if (!S_ISDIR(buf->st_mode)) {
+            continue;
+        }
+        weights[i] = (double)buf->st_size + 1;
+        total_weight += weights[i];
+        dir_amount++;
+    }
+    if (dir_amount > ESTIMATE_MIN_DIRS) {
+        double picks = t_queue->sample_rate * (double)dir_amount;
+        picks = picks > ESTIMATE_MIN_DIRS ? picks : ESTIMATE_MIN_DIRS;
+        //the directories that are certain to be picked are taken out, until the others are all below 1
+        bool capped = true;
+        while (capped) {
+            capped = false;
+            for (size_t i = 0; i < reader->amount; i++) {
+                if (weights[i] > 0 && picks * weights[i] >= total_weight) {
+                    picks--;
+                    total_weight -= weights[i];
+                    weights[i] = 0;
+                    capped = true;
+                }
+            }
+        }
+        for (size_t i = 0; i < reader->amount; i++) {
+            if (weights[i] > 0) {
+                reader->entries[i].sample_rate = picks * weights[i] / total_weight;
+            }
+        }
+    }
+    free(weights);
+}
+
+
+/**
+ * @brief                                      Decides if a directory is read by an estimate. The random numbers
+ *                                             are an xorshift64* generator of the worker, so no lock is needed.
+ *
+ * @param worker                               The worker that found the directory.
+ * @param sample_rate                          The probability that the directory is read.
+ * @return                                     True if the directory is read.
+ */
+bool sample_dir(Worker *worker, double sample_rate) {
+    unsigned long long x = worker->random_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    worker->random_state = x;
+    double random = (double)((x * 0x2545F4914F6CDD1DULL) >> 11) / (double)(1ULL << 53);
+    return random < sample_rate;
+}
+
+
+/**
+ * @brief                                      Scales the totals of a sampled directory by 1 / sample_rate, for
+ *                                             the directories that weren't sampled, and sets the variance that
+ *                                             the sample adds to the estimate of the parent.
+ *
+ * @param totals                               The totals of the directory, which are scaled.
+ * @param sample_rate                          The probability that the directory was sampled.
+ */
+void scale_totals(Mdu_totals *totals, double sample_rate) {
+    double blocks = (double)totals->block_size;
+    totals->variance = (1 - sample_rate) / (sample_rate * sample_rate) * blocks * blocks
+                       + totals->variance / sample_rate;
+    totals->block_size = llround(blocks / sample_rate);
+    totals->bytes = llround((double)totals->bytes / sample_rate);
+    totals->file_amount = lround((double)totals->file_amount / sample_rate);
+    totals->dir_amount = lround((double)totals->dir_amount / sample_rate);
+    totals->error_amount = lround((double)totals->error_amount / sample_rate);
+    totals->unvisited_amount = lround((double)totals->unvisited_amount / sample_rate);
+    for (int i = 0; i < MDU_AGE_BUCKETS; i++) {
+        totals->age_block_size[i] = llround((double)totals->age_block_size[i] / sample_rate);
+    }
+}
+
+
+/**
+ * @brief                                      Adds the totals of a directory onto it's directory node, and
+ *                                             completes the node if nothing inside of it is pending.
+ *
+ *                                             A completed node is given to the directory callback, and it's totals
+ *                                             are added to the parent, which might complete the parent as
+ *                                             well. When a root is completed, it's totals are stored in the task
+ *                                             queue.
+ *
+ * @param worker                               The worker that calculated the directory.
+ * @param node                                 The directory node.
+ * @param path                                 The path to the directory. NULL if it hasn't been put together,
+ *                                             then it's put together for the directory callback.
+ * @param totals                               The totals of the directory and the files directly inside of it.
+ * @param report                               False if the node isn't a readable directory, and shouldn't be given
+ *                                             to the directory callback. Roots are always given to it.
+ */
+void complete_dir(Worker *worker, Dir_node *node, const char *path, const Mdu_totals *totals, bool report) {
+    Task_queue *t_queue = worker->t_queue;
+    Mdu_totals node_totals;
+    while (node != NULL && dir_node_release(node, totals)) {
+        double duration = seconds_since(&t_queue->start_time);
+        if (report && t_queue->dir_callback != NULL) {
+            char *node_path = path == NULL ? dir_node_path(node) : NULL;
+            Mdu_entry entry = { .path = path == NULL ? node_path : path, .stat = node->has_stat ? &node->stat : NULL,
+                                .id = node->id, .parent_id = node->parent == NULL ? 0 : node->parent->id,
+                                .read_error = node->read_error, .totals = node->totals,
+                                .depth = node->depth, .duration = duration, .worker = worker->id };
+            t_queue->dir_callback(&entry, t_queue->callback_data);
+            free(node_path);
+        }
+        if (node->parent == NULL) {
+            pthread_mutex_lock(&t_queue->mutex);
+            t_queue->totals = node->totals;
+            t_queue->duration = duration;
+            pthread_mutex_unlock(&t_queue->mutex);
+        }
+        if (t_queue->shared_amount > 0 && node->has_stat && S_ISDIR(node->stat.st_mode)) {
+            share_dir(t_queue, &node->stat, &node->totals, duration);
+        }
+        Dir_node *parent = node->parent;
+        node_totals = node->totals;
+        if (node->sample_rate < 1) {
+            scale_totals(&node_totals, node->sample_rate);
+        }
+        totals = &node_totals;
+        destroy_dir_node(node);
+        node = parent;
+        path = NULL;
+        report = true;
+    }
+}
+
+
+/**
+ * @brief                                      Gives a root that wasn't calculated by itself to the directory callback,
+ *                                             the same way as a root that has been calculated. It's result is from a
+ *                                             checkpoint, or from the scan of another root.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param path                                 The path of the root.
+ * @param result                               The result of the root.
+ */
+void report_root(Task_queue *t_queue, const char *path, const Mdu_result *result) {
+    if (t_queue->dir_callback != NULL) {
+        Mdu_entry entry = { .path = path, .stat = NULL, .id = next_dir_id(t_queue->workers[0]), .parent_id = 0,
+                            .read_error = false, .totals = result->totals, .depth = 0,
+                            .duration = result->duration, .worker = 0 };
+        t_queue->dir_callback(&entry, t_queue->callback_data);
+    }
+}
+
+
+/**
+ * @brief                                      Finds the roots that are inside of another root, or are the same as an
+ *                                             earlier root, by their canonical paths. Only the roots that are
+ *                                             directories are shared, and they are identified by their device and
+ *                                             inode numbers, stat'ed the same way as when they are calculated.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param roots                                The paths of the roots.
+ * @param root_amount                          Amount of roots.
+ */
+void find_shared_roots(Task_queue *t_queue, const char *const *roots, int root_amount) {
+    char **canonical = malloc(root_amount * sizeof(char *));
+    error_handler_null(canonical, NULL, "Memory for canonical paths couldn't be allocated", true);
+    for (int i = 0; i < root_amount; i++) {
+        canonical[i] = realpath(roots[i], NULL);
+    }
+    t_queue->shared_roots = malloc(root_amount * sizeof(Shared_root));
+    error_handler_null(t_queue->shared_roots, NULL, "Memory for shared roots couldn't be allocated", true);
+
+    for (int j = 0; j < root_amount; j++) {
+        bool nested = false;
+        for (int i = 0; !nested && canonical[j] != NULL && i < root_amount; i++) {
+            nested = i != j && canonical[i] != NULL && (path_inside(canonical[i], canonical[j])
+                                                        || (i < j && strcmp(canonical[i], canonical[j]) == 0));
+        }
+        struct stat buf;
+        if (nested && stat_entry(t_queue, AT_FDCWD, roots[j], &buf, 0) == 0 && S_ISDIR(buf.st_mode)) {
+            t_queue->shared_roots[t_queue->shared_amount++] = (Shared_root) { .dev = buf.st_dev, .ino = buf.st_ino,
+                                                                               .index = j, .done = false };
+        }
+    }
+    for (int i = 0; i < root_amount; i++) {
+        free(canonical[i]);
+    }
+    free(canonical);
+}
+
+
+/**
+ * @brief                                      Checks if a canonical path is strictly inside of another one.
+ *
+ * @param outer                                The canonical path that might hold the other.
+ * @param inner                                The canonical path that might be inside of outer.
+ * @return                                     True if inner is below outer.
+ */
+bool path_inside(const char *outer, const char *inner) {
+    size_t length = strlen(outer);
+    if (strncmp(outer, inner, length) != 0) {
+        return false;
+    }
+    //the root directory is the only canonical path that ends with '/'
+    return outer[length - 1] == '/' ? inner[length] != '\0' : inner[length] == '/';
+}
+
+
+/**
+ * @brief                                      Stores the totals of a completed directory as the result of the shared
+ *                                             roots that are the same directory, and that aren't done.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param buf                                  The struct stat of the directory.
+ * @param totals                               The totals of the directory's file tree.
+ * @param duration                             Seconds since the calculation of the current root started.
+ */
+void share_dir(Task_queue *t_queue, const struct stat *buf, const Mdu_totals *totals, double duration) {
+    for (int i = 0; i < t_queue->shared_amount; i++) {
+        Shared_root *shared = &t_queue->shared_roots[i];
+        //the identity never changes, so only a match is locked
+        if (shared->dev != buf->st_dev || shared->ino != buf->st_ino) {
+            continue;
+        }
+        pthread_mutex_lock(&t_queue->mutex);
+        if (!shared->done) {
+            shared->result = (Mdu_result) { .totals = *totals, .duration = duration,
+                                            .permission = totals->error_amount == 0 };
+            shared->done = true;
+        }
+        pthread_mutex_unlock(&t_queue->mutex);
+    }
+}
+
+
+/**
+ * @brief                                      Finds a shared root that is done, and is the same directory.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param buf                                  The struct stat of the directory.
+ * @return                                     The shared root. NULL if the directory isn't a root that is done.
+ */
+const Shared_root *shared_dir(Task_queue *t_queue, const struct stat *buf) {
+    for (int i = 0; i < t_queue->shared_amount; i++) {
+        Shared_root *shared = &t_queue->shared_roots[i];
+        if (shared->dev != buf->st_dev || shared->ino != buf->st_ino) {
+            continue;
+        }
+        pthread_mutex_lock(&t_queue->mutex);
+        bool done = shared->done;
+        pthread_mutex_unlock(&t_queue->mutex);
+        if (done) {
+            return shared;
+        }
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief                                      Gives the result of a root, if it's a shared root that has been done
+ *                                             already.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param index                                The index of the root.
+ * @param result                               Where the result is stored.
+ * @return                                     True if the root is done.
+ */
+bool shared_result(Task_queue *t_queue, int index, Mdu_result *result) {
+    for (int i = 0; i < t_queue->shared_amount; i++) {
+        Shared_root *shared = &t_queue->shared_roots[i];
+        if (shared->index == index && shared->done) {
+            *result = shared->result;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/**
+ * @brief                                      Responsible for telling the threadpool to shutdown.
+ *
+ *                                             Doesn't do much apart from changing the task queues shutdown variable
+ *                                             to true.
+ *
+ * @param task                                 The kill task.
+ * @param worker                               A worker, belonging to the task queue containing the shutdown variable.
+ * @return                                     Returns -1 indicating that this function is only for shutting down.
+ */
+blkcnt_t shutdown_threads(Task *task, Worker *worker) {
+    Task_queue *queue = worker->t_queue;
+    pthread_mutex_lock(&queue->mutex);
+    (void)task;
+    queue->shutdown = true;
+    //wakes the parked threads so that they can stop as well
+    pthread_cond_broadcast(&queue->park_cond);
+    pthread_mutex_unlock(&queue->mutex);
+    return -1;
+}
+
+
+/**
+ * @brief                                      Responsible for adding a batch of tasks to the top of a worker's
+ *                                             deque, and signaling the threadpool when this has occurred.
+ *
+ *                                             The whole batch is added with one lock of the deque and one lock of
+ *                                             the task queue. One thread is signalled for a single task, otherwise
+ *                                             all waiting threads are woken with one broadcast.
+ *                                             The worker will run the tasks next (depth first), unless other
+ *                                             threads steal them.
+ *
+ * @param worker                               Pointer to the worker that is running the current task.
+ * @param tasks                                List of the tasks that will be added. Is left empty.
+ * @param task_amount                          Amount of tasks in the list.
+ */
+void add_tasks(Worker *worker, List *tasks, int task_amount) {
+    Task_queue *t_queue = worker->t_queue;
+    push_tasks(worker, tasks, task_amount);
+    //the tasks are counted already, the lock makes sure that a thread about to wait gets the signal
+    pthread_mutex_lock(&t_queue->mutex);
+    int check_signal;
+    if (task_amount == 1) {
+        check_signal = pthread_cond_signal(&t_queue->cond);
+    } else {
+        check_signal = pthread_cond_broadcast(&t_queue->cond);
+    }
+    error_handler_value(0, check_signal, NULL, "Error! cond_signal failed\n",
+                        false);
+    pthread_mutex_unlock(&t_queue->mutex);
+}
+
+
+/**
+ * @brief                                      Responsible for adding a task to the shared task queue, and
+ *                                             signaling the threadpool when this has occurred.
+ *
+ *                                             Used for tasks that doesn't come from a worker, the start task
+ *                                             and the kill tasks.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param task                                 Pointer to the task that will be added.
+ */
+void inject_task(Task_queue *t_queue, Task *task) {
+    pthread_mutex_lock(&t_queue->mutex);
+    enqueue(t_queue, task);
+    int check_signal = pthread_cond_signal(&t_queue->cond);
+    error_handler_value(0, check_signal, NULL, "Error! cond_signal failed\n",
+                        false);
+    pthread_mutex_unlock(&t_queue->mutex);
+}
+
+
+/**
+ * @brief                                      Adds a list of tasks to the shared task queue, in one operation, and
+ *                                             wakes every waiting thread. Used for the tasks of a checkpoint.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param tasks                                List of the tasks that will be added. Is left empty.
+ */
+void inject_tasks(Task_queue *t_queue, List *tasks) {
+    long task_amount = 0;
+    for (ListPos pos = list_first(tasks); !list_pos_equal(pos, list_end(tasks)); pos = list_next(pos)) {
+        task_amount++;
+    }
+    if (task_amount == 0) {
+        return;
+    }
+    pthread_mutex_lock(&t_queue->mutex);
+    list_splice(list_first(t_queue->task_q), tasks);
+    __atomic_add_fetch(&t_queue->queue_length, task_amount, __ATOMIC_SEQ_CST);
+    int check_signal = pthread_cond_broadcast(&t_queue->cond);
+    error_handler_value(0, check_signal, NULL, "Error! cond_signal failed\n",
+                        false);
+    pthread_mutex_unlock(&t_queue->mutex);
+}
+
+
+/**
+ * @brief                                      Takes a task for a worker.
+ *
+ *                                             The worker's own deque is tried first, from the top, then the shared
+ *                                             task queue. Otherwise a task is stolen from the bottom of another
+ *                                             worker's deque, which is the shallowest task that worker has.
+ *                                             Workers on the same NUMA node are stolen from first.
+ *
+ * @param worker                               The worker that will run the task.
+ * @return                                     The task that was taken. NULL if other threads took every task that
+ *                                             was found first.
+ */
+Task *take_task(Worker *worker) {
+    Task_queue *t_queue = worker->t_queue;
+    Task *task = pop_task(worker);
+    if (task == NULL) {
+        pthread_mutex_lock(&t_queue->mutex);
+        task = dequeue(t_queue);
+        pthread_mutex_unlock(&t_queue->mutex);
+    }
+    for (int i = 1; task == NULL && i < t_queue->thread_amount; i++) {
+        task = steal_task(t_queue->workers[worker->steal_order[i - 1]]);
+    }
+    return task;
+}
+
+
+/**
+ * @brief                                      Responsible for running the threads, the main function of the
+ *                                             threadpool.
+ *
+ *                                             When no task is in the queue or the deques, the threads wait for a
+ *                                             condition variable to be signalled when a new task has been added.
+ *
+ * @param worker                               The worker of the thread, the task queue is reached through it.
+ * @return                                     returns NULL.
+ */
+void *run_thread(Worker *worker) {
+    Task_queue *t_queue = worker->t_queue;
+    if (worker->cpu >= 0) {
+        affinity_pin_thread(worker->cpu);
+    }
+
+    pthread_mutex_lock(&t_queue->mutex);
+    //loops until a kill task has been added to the queue
+    while (!t_queue->shutdown) {
+
+        //no task is taken while the threads are paused for a checkpoint
+        if (t_queue->pausing || (t_queue->checkpoint != NULL
+                                 && checkpoint_due(t_queue->checkpoint, scan_stopped(t_queue)))) {
+            pause_for_checkpoint(t_queue);
+            continue;
+        }
+
+        //threads above the thread limit are parked until the limit is raised, or the pool shuts down
+        if (worker->id >= t_queue->thread_limit) {
+            //passes on a signal that might have been meant for a thread taking tasks
+            if (waiting_tasks(t_queue) > 0) {
+                pthread_cond_signal(&t_queue->cond);
+            }
+            int check_wait = pthread_cond_wait(&t_queue->park_cond, &t_queue->mutex);
+            error_handler_value(0, check_wait, NULL, "Error! cond_wait failed\n",
+                                false);
+            continue;
+        }
+
+        //the threads wait here until a task has been added, and a signal is sent
+        if (waiting_tasks(t_queue) == 0) {
+            int check_wait = pthread_cond_wait(&t_queue->cond, &t_queue->mutex);
+            error_handler_value(0, check_wait, NULL, "Error! cond_wait failed\n",
+                                false);
+            continue;
+        }
+        //the thread counts as running before it takes the task, so the scan never looks done in between
+        t_queue->t_running++;
+        pthread_mutex_unlock(&t_queue->mutex);
+        Task *task = take_task(worker);
+        if (task == NULL) {
+            //the tasks were taken by other threads first, the counts are checked again
+            pthread_mutex_lock(&t_queue->mutex);
+            t_queue->t_running--;
+            if (t_queue->fd_waiting > 0) {
+                pthread_cond_broadcast(&t_queue->fd_cond);
+            }
+            bool done = !t_queue->shutdown && waiting_tasks(t_queue) == 0;
+            int t_running = t_queue->t_running;
+            pthread_mutex_unlock(&t_queue->mutex);
+            kill_task_initializer(t_queue, 0, done, t_running);
+            pthread_mutex_lock(&t_queue->mutex);
+            continue;
+        }
+        run_task(worker, task);
+        pthread_mutex_lock(&t_queue->mutex);
+        kill_task(task);
+    }
+    pthread_mutex_unlock(&t_queue->mutex);
+    return NULL;
+}
+
+
+/**
+ * @brief                                      Pauses the thread for a checkpoint. The mutex of the task queue has to
+ *                                             be held.
+ *
+ *                                             The threads wait until every running task is done. The last thread to
+ *                                             pause writes the checkpoint, and wakes the others.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ */
+void pause_for_checkpoint(Task_queue *t_queue) {
+    t_queue->pausing = true;
+    if (t_queue->t_running > 0) {
+        int check_wait = pthread_cond_wait(&t_queue->cond, &t_queue->mutex);
+        error_handler_value(0, check_wait, NULL, "Error! cond_wait failed\n",
+                            false);
+        return;
+    }
+    write_checkpoint(t_queue->checkpoint, t_queue, scan_stopped(t_queue));
+    t_queue->pausing = false;
+    pthread_cond_broadcast(&t_queue->cond);
+}
+
+
+/**
+ * @brief                                      Responsible for starting a task.
+ *
+ *                                             Runs the function pointed to, which is contained in the task.
+ *                                             Also adds the amount of entries the task processed onto the common
+ *                                             entries variable.
+ *
+ * @param worker                               The worker running the task, with the task queue containing settings.
+ * @param task                                 The task that will run.
+ */
+void run_task(Worker *worker, Task *task) {
+    Task_queue *t_queue = worker->t_queue;
+    blkcnt_t temp_block_size;
+    //make sure that the function pointed to is not inside of a mutex
+    temp_block_size = task->task_pointer(task, worker);
+    pthread_mutex_lock(&t_queue->mutex);
+
+    //checks if the task that has been run is a kill-task or a regular
+    if (temp_block_size > -1) {
+        t_queue->entries += task->entries;
+    }
+    if (task->carried_fd) {
+        t_queue->carried_fds--;
+    }
+    t_queue->t_running--;
+    t_queue->tasks_done++;
+    //the directories of the task are closed, a thread waiting for file descriptors can try again
+    if (t_queue->fd_waiting > 0) {
+        pthread_cond_broadcast(&t_queue->fd_cond);
+    }
+
+    bool queue_empty = waiting_tasks(t_queue) == 0;
+    int t_running = t_queue->t_running;
+
+    pthread_mutex_unlock(&t_queue->mutex);
+    kill_task_initializer(t_queue, temp_block_size, queue_empty, t_running);
+
+}
+
+
+/**
+ * @brief                                      Creates tasks for shutting down the threadpool.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param temp_block_size                      Makes sure that killing tasks only can be made from a regular task.
+ * @param queue_empty                          True if the queue is empty.
+ * @param t_running                            Amount of threads in the threadpool currently doing work.
+ */
+void kill_task_initializer(Task_queue *t_queue, blkcnt_t temp_block_size, bool queue_empty, int t_running) {
+    if ( queue_empty && (t_running == 0) && (temp_block_size > -1) ) {
+        //creates the same amount of kill threads as thread amount
+        for (int i = 0; i < t_queue->thread_amount; i++) {
+            Task *new_task = create_task(NULL,
+                                         (void (*)(struct task *, Worker *)) (void (*)(void)) shutdown_threads);
+            inject_task(t_queue, new_task);
+        }
+    }
+}
+
+
+/**
+ * @brief                                      Starts the threadpool, adds the first task, and joins all of the threads
+ *                                             when done.
+ *
+ *                                             With one thread, the calling thread runs the task instead.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param start_path                           Name of the start path.
+ * @param tasks                                Tasks of the root from a checkpoint, which are added instead of the first
+ *                                             task. Is left empty. Empty if the root is started from the beginning.
+ */
+void run_mult_thread(Task_queue *t_queue, const char *start_path, List *tasks) {
+    clock_gettime(CLOCK_MONOTONIC, &t_queue->start_time);
+    if (list_is_empty(tasks)) {
+        //start task
+        Task *start_task = create_task(create_dir_node(NULL, start_path, next_dir_id(t_queue->workers[0])),
+                                       (void (*)(struct task *, Worker *)) (void (*)(void)) get_block_size_mult);
+        inject_task(t_queue, start_task);
+    }
+    inject_tasks(t_queue, tasks);
+
+    if (t_queue->thread_amount == 1) {
+        run_thread(t_queue->workers[0]);
+        return;
+    }
+
+    pthread_t threads[t_queue->thread_amount];
+    int thread_spawned = 0;
+
+    //creates the threads, in auto mode only the ones allowed to take tasks
+    spawn_threads(t_queue, threads, &thread_spawned, t_queue->thread_limit);
+
+    if (t_queue->auto_threads) {
+        run_thread_controller(t_queue, threads, &thread_spawned);
+    }
+
+    //join threads
+    for (int i = 0; i < thread_spawned; i++) {
+        int pthread_join_check = pthread_join(threads[i], NULL);
+        error_handler_value(0, pthread_join_check, "Could not join thread: ",
+                            (char *) threads[i], false);
+    }
+}
+
+
+/**
+ * @brief                                      Creates threads for the threadpool until amount threads has been
+ *                                             created in total.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param threads                              Array of thread ids, with room for thread_amount threads.
+ * @param thread_spawned                       Pointer to the amount of threads that has been created so far.
+ * @param amount                               The total amount of threads that should exist.
+ */
+void spawn_threads(Task_queue *t_queue, pthread_t *threads, int *thread_spawned, int amount) {
+    while (*thread_spawned < amount) {
+        int i = *thread_spawned;
+        int pthread_create_check = pthread_create(&threads[i], NULL, (void *(*)(void *)) run_thread,
+                                                  t_queue->workers[i]);
+        error_handler_value(0, pthread_create_check, "Error! Couldn't create thread: ",
+                            (char *) threads[i],false);
+        (*thread_spawned)++;
+    }
+}
+
+
+/**
+ * @brief                                      Adjusts the amount of threads taking tasks while the threadpool is
+ *                                             running (-j auto). Runs in the main thread until the pool shuts down.
+ *
+ *                                             Every AUTO_INTERVAL_MS the amount of processed directory entries is
+ *                                             measured. If there are more tasks in the queue than threads taking
+ *                                             them, threads are added. If the added threads didn't raise the
+ *                                             throughput by AUTO_MIN_GAIN they are parked again, and the limit is
+ *                                             held for AUTO_HOLD_INTERVALS. Threads are also parked when the queue
+ *                                             is empty and they have nothing to do.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ * @param threads                              Array of thread ids, with room for thread_amount threads.
+ * @param thread_spawned                       Pointer to the amount of threads that has been created so far.
+ */
+void run_thread_controller(Task_queue *t_queue, pthread_t *threads, int *thread_spawned) {
+    struct timespec interval = { .tv_sec = 0, .tv_nsec = AUTO_INTERVAL_MS * 1000000L };
+    long last_entries = 0;
+    long last_rate = 0;
+    int last_step = 0;
+    int hold = 0;
+
+    pthread_mutex_lock(&t_queue->mutex);
+    while (!t_queue->shutdown) {
+        pthread_mutex_unlock(&t_queue->mutex);
+        nanosleep(&interval, NULL);
+        pthread_mutex_lock(&t_queue->mutex);
+        if (t_queue->shutdown) { break; }
+
+        long rate = t_queue->entries - last_entries;
+        last_entries = t_queue->entries;
+        int limit = t_queue->thread_limit;
+        int step = 0;
+
+        if (last_step > 0 && (double)rate < (double)last_rate * AUTO_MIN_GAIN) {
+            //the last added threads didn't pay off, so they are parked again
+            step = -last_step;
+            hold = AUTO_HOLD_INTERVALS;
+        } else if (hold > 0) {
+            hold--;
+        } else if (waiting_tasks(t_queue) > limit && limit < t_queue->thread_amount) {
+            step = limit / 4 > 1 ? limit / 4 : 1;
+            if (limit + step > t_queue->thread_amount) { step = t_queue->thread_amount - limit; }
+        } else if (waiting_tasks(t_queue) == 0 && t_queue->t_running < limit && limit > AUTO_THREAD_START) {
+            //idle threads are parked, but never below the start amount
+            step = (t_queue->t_running > AUTO_THREAD_START ? t_queue->t_running : AUTO_THREAD_START) - limit;
+        }
+
+        t_queue->thread_limit = limit + step;
+        last_step = step;
+        last_rate = rate;
+        if (step > 0) {
+            spawn_threads(t_queue, threads, thread_spawned, t_queue->thread_limit);
+            pthread_cond_broadcast(&t_queue->park_cond);
+        }
+    }
+    pthread_mutex_unlock(&t_queue->mutex);
+}
+
+
+/**
+ * @brief                                      Pins the workers to CPUs, and places them on the NUMA node of
+ *                                             their CPU (-p).
+ *
+ *                                             Every worker is created again by a short lived thread pinned to
+ *                                             the worker's CPU. Memory is placed on the node of the thread that
+ *                                             first touches it, so the worker ends up on the local node. The
+ *                                             workers threads are pinned to the same CPU when they start, which
+ *                                             keeps the tasks and list nodes they allocate local as well.
+ *                                             Has to be done before any thread of the threadpool is started.
+ *
+ * @param t_queue                              Pointer to a task queue.
+ */
+void place_workers(Task_queue *t_queue) {
+    int cpu_amount;
+    int *cpus = affinity_cpus(&cpu_amount);
+
+    for (int i = 0; i < t_queue->thread_amount; i++) {
+        Placement placement = { .t_queue = t_queue, .id = i, .cpu = cpus[i % cpu_amount], .worker = NULL };
+        pthread_t thread;
+        int pthread_create_check = pthread_create(&thread, NULL, place_worker, &placement);
+        error_handler_value(0, pthread_create_check, NULL, "Error! Couldn't create thread\n", false);
+        int pthread_join_check = pthread_join(thread, NULL);
+        error_handler_value(0, pthread_join_check, NULL, "Error! Couldn't join thread\n", false);
+
+        destroy_worker(t_queue->workers[i]);
+        t_queue->workers[i] = placement.worker;
+    }
+    set_steal_order(t_queue);
+    free(cpus);
+}
+
+
+/**
+ * @brief                                      Creates a worker from a thread pinned to the worker's CPU.
+ *
+ * @param placement                            Pointer to a placement, where the created worker is stored.
+ * @return                                     returns NULL.
+ */
+void *place_worker(void *placement) {
+    Placement *p = placement;
+    affinity_pin_thread(p->cpu);
+    p->worker = create_worker(p->t_queue, p->id);
+    p->worker->cpu = p->cpu;
+    p->worker->node = affinity_node_of_cpu(p->cpu);
+    return NULL;
+}
@@ -0,0 +1,364 @@
+/**
+ * @defgroup libmdu_h libmdu
+ *
+ * @brief A library for calculating the size of file trees with multiple threads, the same way as [du].
+ *
+ * The size of one or more roots is calculated with a threadpool, and the user can be told about every
+ * directory and file on the way through callbacks. All of the state belongs to the scan, so several scans
+ * can run at the same time in one process.
+ *
+ * Sizes are given in blocks of 512 bytes, as st_blocks in struct stat.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 2.2
+ *
+ * @{
+ */
+
+#ifndef LIBMDU_H
+#define LIBMDU_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#define MDU_API __attribute__((visibility("default")))
+#define MDU_HISTOGRAM_BUCKETS 64
+#define MDU_AGE_BUCKETS 8
+#define MDU_EXTENSION_MAX 16
+
+/**
+ * @brief                  The symbolic links that a scan follows.
+ */
+typedef enum mdu_follow {
+    MDU_FOLLOW_NONE,
+    MDU_FOLLOW_ROOTS,
+    MDU_FOLLOW_ALL
+} Mdu_follow;
+
+/**
+ * @brief                  The time of an entry that it's age is counted from.
+ */
+typedef enum mdu_age {
+    MDU_AGE_NONE,
+    MDU_AGE_MTIME,
+    MDU_AGE_ATIME
+} Mdu_age;
+
+/**
+ * @brief                  The errors that stop a scan before any root is calculated.
+ */
+typedef enum mdu_error {
+    MDU_ERROR_NONE,
+    MDU_ERROR_CHECKPOINT, //the checkpoint to resume from isn't a checkpoint that can be read
+    MDU_ERROR_CHECKPOINT_ROOTS //the checkpoint to resume from is a checkpoint of other roots
+} Mdu_error;
+
+/**
+ * @brief                  The owner of an entry that it's files and blocks are counted for.
+ */
+typedef enum mdu_owner_key {
+    MDU_OWNER_NONE,
+    MDU_OWNER_UID,
+    MDU_OWNER_GID
+} Mdu_owner_key;
+
+/**
+ * @brief                  A struct with the files and blocks that a user or a group owns.
+ *
+ * @elem id                The user or group id.
+ * @elem file_amount       Amount of files, and other entries that aren't directories, that are owned.
+ * @elem block_size        The size in blocks of 512 bytes of every entry that is owned, directories included.
+ */
+typedef struct mdu_owner {
+    id_t id;
+    long file_amount;
+    blkcnt_t block_size;
+} Mdu_owner;
+
+/**
+ * @brief                  The types of the files that extensions are counted for. Directories aren't counted.
+ */
+typedef enum mdu_file_type {
+    MDU_TYPE_REGULAR,
+    MDU_TYPE_SYMLINK,
+    MDU_TYPE_SOCKET,
+    MDU_TYPE_FIFO,
+    MDU_TYPE_DEVICE,
+    MDU_TYPE_OTHER
+} Mdu_file_type;
+
+/**
+ * @brief                  A struct with the files and blocks of a file type and extension.
+ *
+ * @elem type              The file type.
+ * @elem extension         The extension, what comes after the last '.' of the name, without the '.'. Empty for
+ *                         a name without one, that starts with it's only '.', or has an extension longer than
+ *                         MDU_EXTENSION_MAX bytes.
+ * @elem file_amount       Amount of files of the type, that have the extension.
+ * @elem block_size        The size in blocks of 512 bytes of the files.
+ */
+typedef struct mdu_extension {
+    Mdu_file_type type;
+    const char *extension;
+    long file_amount;
+    blkcnt_t block_size;
+} Mdu_extension;
+
+/**
+ * @brief                  A struct with the file types and extensions of a file tree.
+ *
+ * @elem extensions        Array of the file types and extensions, with the one of the most blocks first. The
+ *                         extensions are stored in the same allocation, which is made by the scan, and freed by
+ *                         the caller with free(). NULL if no file was found.
+ * @elem extension_amount  Amount of file types and extensions.
+ */
+typedef struct mdu_extension_table {
+    Mdu_extension *extensions;
+    long extension_amount;
+} Mdu_extension_table;
+
+/**
+ * @brief                  A struct with the owners of a file tree.
+ *
+ * @elem owners            Array of the owners, with the owner of the most blocks first. Allocated by the scan,
+ *                         and freed by the caller with free(). NULL if no entry was found.
+ * @elem owner_amount      Amount of owners.
+ */
+typedef struct mdu_owner_table {
+    Mdu_owner *owners;
+    long owner_amount;
+} Mdu_owner_table;
+
+/**
+ * @brief                  A struct with the distribution of the sizes of the regular files of a file tree.
+ *
+ *                         Bucket 0 holds the empty files, and bucket i the files of at least 2^(i - 1) and less
+ *                         than 2^i bytes.
+ *
+ * @elem file_amount       Amount of files in every bucket.
+ * @elem block_size        The size in blocks of 512 bytes of the files in every bucket.
+ */
+typedef struct mdu_histogram {
+    long file_amount[MDU_HISTOGRAM_BUCKETS];
+    blkcnt_t block_size[MDU_HISTOGRAM_BUCKETS];
+} Mdu_histogram;
+
+/**
+ * @brief                  A struct with the options of a scan.
+ *
+ * @elem thread_amount     The amount of threads. 1 calculates the size in the calling thread.
+ * @elem auto_threads      True if the amount of threads should be adjusted while running. thread_amount
+ *                         is ignored in that case.
+ * @elem pin_threads       True if the threads should be pinned to CPUs and placed on their NUMA node.
+ * @elem follow            The symbolic links that are followed. MDU_FOLLOW_NONE counts every link as a file,
+ *                         MDU_FOLLOW_ROOTS follows the roots that are links, and MDU_FOLLOW_ALL follows every
+ *                         link. When every link is followed, a directory that has already been reached in the
+ *                         file tree of a root, through a link or a cycle, is left out the next time.
+ * @elem share_roots       True if a root that is inside of another root, or the same as an earlier one, should
+ *                         only be calculated once. It's result is taken from the directory in the scan of the other
+ *                         root, or it's calculated first and used as is when the other root reaches it. Only the root
+ *                         itself is given to dir_callback the second time, not the entries inside of it. Ignored
+ *                         when every link is followed, or histograms, owners or extensions are collected.
+ * @elem sort_inodes       True if the entries of a directory should be stat'ed in the order of their inode
+ *                         numbers, instead of the order they are read in. Reads the inode table in order
+ *                         when the inodes aren't cached, which saves seeks on spinning disks.
+ * @elem deadline          Seconds from the start of the scan until directories stop being read. A directory
+ *                         that is reached after that is counted with only it's own size, as unvisited. 0 for
+ *                         no deadline.
+ * @elem sample_rate       The probability that a directory below a root is read, between 0 and 1. Below 1 the
+ *                         scan is an estimate, where the totals of a directory that is read are scaled by
+ *                         1 / sample_rate, and the variance of the estimated blocks is given in the totals.
+ *                         1 for a full scan.
+ * @elem cancel            A flag that cancels the scan when it's set to non-zero, which a signal handler can do.
+ *                         The directories that are being read are finished, and the directories that are
+ *                         reached after that are counted as unvisited, as after the deadline. NULL if the scan
+ *                         can't be cancelled.
+ * @elem histograms        Array with room for one histogram for every root, where the distribution of the sizes
+ *                         of the regular files of each root is stored. Every thread counts the files it finds in
+ *                         it's own histogram, which are added together when the root is done. The files of the
+ *                         directories that are read are counted as they are, even in an estimate. NULL if no
+ *                         histograms are wanted.
+ * @elem owner_key         Counts the files and blocks of every user id, or group id, of every root in owners.
+ *                         MDU_OWNER_NONE if owners aren't counted.
+ * @elem owners            Array with room for the owners of every root. Every thread counts the entries it stats
+ *                         in it's own map, which are added together when the root is done. Ignored when owner_key
+ *                         is MDU_OWNER_NONE.
+ * @elem extensions        Array with room for the file types and extensions of every root, that the files and
+ *                         blocks of every file, and other entry that isn't a directory, are counted for. Every
+ *                         thread counts the files it finds in it's own map, which are added together when the
+ *                         root is done. NULL if they aren't counted.
+ * @elem age               The time that the age of every entry is counted from, st_mtime or st_atime. The blocks of
+ *                         every entry are added to the age bucket of the entry in the totals. MDU_AGE_NONE if
+ *                         ages aren't collected.
+ * @elem age_boundaries    Ascending ages in seconds, that separate the age buckets. Bucket i holds the entries
+ *                         that are younger than age_boundaries[i], and at least as old as age_boundaries[i - 1].
+ *                         The last bucket holds the entries that are older than every boundary. The ages are
+ *                         counted from the start of the scan.
+ * @elem age_boundary_amount Amount of age boundaries, at most MDU_AGE_BUCKETS - 1.
+ * @elem checkpoint        The path of a file that the state of the scan is written to every checkpoint_interval
+ *                         seconds, and when the scan is cancelled or it's deadline passes. The file is removed when
+ *                         the scan is complete. NULL if no checkpoints are written.
+ * @elem checkpoint_interval Seconds between two checkpoints. 0 if a checkpoint is only written when the scan stops.
+ * @elem resume            True if the scan should continue from the checkpoint file, if there is one. The roots
+ *                         have to be the same as when it was written. The directories that were completed before
+ *                         the checkpoint aren't given to the callbacks again, but the roots are.
+ */
+typedef struct mdu_options {
+    int thread_amount;
+    bool auto_threads;
+    bool pin_threads;
+    Mdu_follow follow;
+    bool share_roots;
+    bool sort_inodes;
+    double deadline;
+    double sample_rate;
+    volatile sig_atomic_t *cancel;
+    Mdu_histogram *histograms;
+    Mdu_owner_key owner_key;
+    Mdu_owner_table *owners;
+    Mdu_extension_table *extensions;
+    Mdu_age age;
+    const double *age_boundaries;
+    int age_boundary_amount;
+    const char *checkpoint;
+    double checkpoint_interval;
+    bool resume;
+} Mdu_options;
+
+/**
+ * @brief                  A struct with the totals of a file tree, or of a single file.
+ *
+ * @elem block_size        The size in blocks of 512 bytes.
+ * @elem bytes             The apparent size in bytes, the sum of st_size.
+ * @elem file_amount       Amount of files, and other entries that aren't directories.
+ * @elem dir_amount        Amount of directories, the directory itself included.
+ * @elem error_amount      Amount of entries that couldn't be read.
+ * @elem unvisited_amount  Amount of directories that weren't read because the deadline had passed, or the
+ *                         scan was cancelled. The totals are a lower bound if it isn't 0.
+ * @elem variance          The estimated variance of block_size, when the scan is an estimate. 0 otherwise.
+ * @elem age_block_size    The size in blocks of 512 bytes of the entries in every age bucket, when ages are
+ *                         collected. 0 otherwise.
+ */
+typedef struct mdu_totals {
+    blkcnt_t block_size;
+    off_t bytes;
+    long file_amount;
+    long dir_amount;
+    long error_amount;
+    long unvisited_amount;
+    double variance;
+    blkcnt_t age_block_size[MDU_AGE_BUCKETS];
+} Mdu_totals;
+
+/**
+ * @brief                  A struct describing a directory or a file that has been calculated.
+ *
+ *                         Only valid during the callback it is given to.
+ *
+ * @elem path              The path to the directory or file.
+ * @elem stat              The struct stat of the directory or file. NULL if it couldn't be stat'ed.
+ * @elem id                An id of a directory, that no other directory in the scan has. 0 for a file.
+ * @elem parent_id         The id of the directory that the entry is inside of. 0 for a root.
+ * @elem read_error        True if the entry is a directory that couldn't be opened.
+ * @elem totals            The totals of a file, or of the entire file tree of a directory.
+ * @elem depth             How many directories below the root the entry is. 0 for a root.
+ * @elem duration          Seconds from when the calculation of the root started, until the entry was done.
+ *                         For a root, it's the time the whole root took.
+ * @elem worker            The id of the thread calling the callback, between 0 and the amount of threads.
+ *                         Can be used for keeping state per thread without locking.
+ */
+typedef struct mdu_entry {
+    const char *path;
+    const struct stat *stat;
+    long id;
+    long parent_id;
+    bool read_error;
+    Mdu_totals totals;
+    int depth;
+    double duration;
+    int worker;
+} Mdu_entry;
+
+/**
+ * @brief                  A struct with the result of one root.
+ *
+ * @elem totals            The totals of the file tree.
+ * @elem duration          Seconds that the calculation of the root took.
+ * @elem permission        False if some part of the file tree couldn't be read.
+ * @elem error             MDU_ERROR_NONE, or the error that stopped the scan before any root was calculated.
+ */
+typedef struct mdu_result {
+    Mdu_totals totals;
+    double duration;
+    bool permission;
+    Mdu_error error;
+} Mdu_result;
+
+/**
+ * @brief                  A function that is called for directories and files during a scan.
+ *
+ *                         Called from the threads of the scan, at the same time from several threads.
+ *
+ * @param entry            The directory or file.
+ * @param data             The pointer given to mdu_scan.
+ */
+typedef void (*Mdu_callback)(const Mdu_entry *entry, void *data);
+
+
+/**
+ * @brief                  Sets the options to their default values, one thread.
+ *
+ * @param options          The options that will be set.
+ */
+MDU_API void mdu_default_options(Mdu_options *options);
+
+
+/**
+ * @brief                  Gives the amount of threads that a scan with the options can use. The worker of
+ *                         an entry given to a callback is always less than this.
+ *
+ * @param options          The options of the scan. NULL for the default options.
+ * @return                 The amount of threads.
+ */
+MDU_API int mdu_thread_amount(const Mdu_options *options);
+
+
+/**
+ * @brief                  Calculates the size of the file trees of one or more roots.
+ *
+ *                         The roots are calculated one after another, each with all of the threads.
+ *                         A directory is given to dir_callback when the size of it's entire file tree is
+ *                         known, so a directory always comes after the directories inside of it. The roots
+ *                         are given to dir_callback as well, even if they aren't directories, and a root
+ *                         always comes after everything inside of it. Every file, and every other entry
+ *                         that isn't a directory, is given to file_callback.
+ *
+ * @param roots            Array of paths that the size will be calculated upon.
+ * @param root_amount      Amount of paths in roots.
+ * @param options          The options of the scan. NULL for the default options.
+ * @param dir_callback     Called for every directory. NULL if not wanted.
+ * @param file_callback    Called for every file. NULL if not wanted.
+ * @param data             A pointer that is given to the callbacks.
+ * @param results          Array with room for root_amount results, where the result of each root is stored.
+ *                         If the scan couldn't start, every result has the error, and nothing is calculated.
+ * @return                 True if every file tree could be read. False if the scan couldn't start.
+ */
+MDU_API bool mdu_scan(const char *const *roots, int root_amount, const Mdu_options *options,
+                      Mdu_callback dir_callback, Mdu_callback file_callback, void *data, Mdu_result *results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //LIBMDU_H
+
+/**
+ * @}
+ */
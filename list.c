@@ -106,6 +106,26 @@ ListPos list_remove(ListPos pos) {
     return next_pos;
 }
 
+void list_splice(ListPos pos, List *other) {
+    if (list_is_empty(other)) {
+        return;
+    }
+    struct node *first = other->head.next;
+    struct node *last = other->head.prev;
+    struct node *before = pos.node->prev;
+    struct node *after = pos.node;
+
+    // Link the moved nodes between before and after.
+    before->next = first;
+    first->prev = before;
+    last->next = after;
+    after->prev = last;
+
+    // Leave the other list empty.
+    other->head.next = &other->head;
+    other->head.prev = &other->head;
+}
+
 void *list_inspect(ListPos pos) {
     return pos.node->value;
 }
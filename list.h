@@ -165,6 +165,18 @@ ListPos list_insert(ListPos pos, void *value);
  */
 ListPos list_remove(ListPos pos);
 
+/**
+ * @brief                     Moves all of the nodes of another list into the list.
+ *
+ *                            The nodes are inserted right before the pos position, in the same order as they
+ *                            had in other. The values are not copied, and other is left empty.
+ *
+ * @param pos                 Variable of the type ListPos.
+ * @param other               A pointer to the list that the nodes are moved from.
+ *
+ */
+void list_splice(ListPos pos, List *other);
+
 /**
  * @brief                     Returns the value in the node at the pos position.
  *
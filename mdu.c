@@ -4,6 +4,7 @@
  * Apart from [du] this program can also calculate the size by doing it with multithreading.
  *
  * If the multithreading option is chosen, the task will be done with a threadpool implementation.
+ * The calculation itself is done by libmdu, this program parses the arguments and prints the result.
  *
  * The program has the same output as [du] and takes the following arguments and flags.
  * Leave the -j flag and [thread amount] out if you only want to calculate the size with one thread recursively.
@@ -11,15 +12,124 @@
  * [-j] [Thread amount]                        The flag combined with an integer, to specify the amount of
  *                                             threads to be used.
  *
+ * [-j] [auto]                                 Starts with a few threads, and lets the program add or park threads
+ *                                             depending on the measured throughput and the length of the queue.
+ *
+ * [-p]                                        Pins every thread to a CPU. The workers are placed on the NUMA node
+ *                                             of their CPU, and steal tasks from workers on the same node first.
+ *
+ * [-L]                                        Follows every symbolic link. A directory that has already been reached
+ *                                             in the file tree of a path is only counted once, so cycles end.
+ *
+ * [-H]                                        Only follows the paths that are symbolic links.
+ *
+ * [--sort-inodes]                             Stats the entries of every directory in the order of their inode
+ *                                             numbers. Faster on spinning disks when the inodes aren't cached.
+ *
+ * [--deadline=seconds]                        Stops reading directories when the seconds have passed, and
+ *                                             prints what was found so far, a lower bound of the sizes. The
+ *                                             amount of directories that weren't read is printed to stderr. The
+ *                                             lower bound is what was asked for, so the exit status is still 0,
+ *                                             unless some file couldn't be read.
+ *
+ * [--estimate] or [--estimate=rate]           Estimates the sizes by only reading a random sample of the
+ *                                             directories, rate of them, ESTIMATE_DEFAULT_RATE by default. The
+ *                                             95% confidence interval of every root is printed to stderr.
+ *
+ * [-d] [depth] or [--max-depth=depth]         Also prints the directories down to the depth below the roots.
+ *                                             Default is 0, which only prints the roots.
+ *
+ * [--format=text] or [--format=ndjson]        The text format is the same as [du]. The ndjson format prints
+ *                                             one JSON object on each line, with the path, blocks, bytes, files,
+ *                                             dirs, errors, unvisited directories, the half width of the 95%
+ *                                             confidence interval of the blocks when estimating, depth and the
+ *                                             duration in seconds since the scan of the root started. The lines
+ *                                             of --histogram, --by-owner and --by-type also have the path of their
+ *                                             root, and a type of histogram, owner or extension.
+ *
+ * [-a] or [--all]                             Also prints the files, down to the depth of -d. Without -d, every
+ *                                             file and directory is printed.
+ *
+ * [--order=unordered] or [--order=path]       Unordered prints the paths below a root as soon as possible, in
+ *                                             no particular order, and the root after them. Path sorts the paths
+ *                                             of each root, with a directory right after the paths inside of it,
+ *                                             as in [du].
+ *
+ * [--histogram]                               Also prints the distribution of the sizes of the regular files of every
+ *                                             path, after the paths. Each line has the amount of files, their blocks,
+ *                                             the range of sizes in bytes, and the path, for every range of sizes
+ *                                             between two powers of 2 that has files in it.
+ *
+ * [--by-owner] or [--by-owner=gid]           Also prints the blocks and files that every user, or group with gid,
+ *                                             owns in every path, after the paths. Each line has the blocks, the
+ *                                             files, the name of the owner, or it's id if it has no name, and the
+ *                                             path, with the owner of the most blocks first.
+ *
+ * [--by-type]                                 Also prints the blocks and files of every file type and extension in
+ *                                             every path, after the paths. Each line has the blocks, the files, the
+ *                                             type, which is regular, symlink, socket, fifo, device or other, the
+ *                                             extension, - for none, and the path, with the most blocks first.
+ *                                             Directories aren't counted.
+ *
+ * [--age=mtime] or [--age=atime]             Also prints the blocks of every path by the age of the entries, the
+ *                                             time since they were modified, or accessed. The blocks of every age
+ *                                             bucket are printed between the blocks and the path, youngest first,
+ *                                             or as an ages array in ndjson.
+ *
+ * [--age-buckets=ages]                        The ages, separated by commas, that separate the age buckets, such
+ *                                             as 30d,1y. Each age is a number with s, h, d, w or y after it, days
+ *                                             if nothing is. AGE_DEFAULT_BOUNDARIES by default.
+ *
+ * [-o] [file] or [--export=file]              Writes the scan as an export file of [ncdu] instead of printing,
+ *                                             which can be browsed with ncdu -f file. - writes it to stdout.
+ *                                             Only one path can be exported.
+ *
+ * [-s] [file] or [--snapshot=file]            Also writes the directories of the scan to a binary snapshot file.
+ *
+ * [--load=file]                               Reads a snapshot instead of scanning. The paths are looked up in the
+ *                                             snapshot, and printed together with their directories down to -d.
+ *                                             Without paths, the roots of the snapshot are printed. The snapshot
+ *                                             has no files, so -a, --histogram, --by-owner, --by-type and --age
+ *                                             can't be used with it.
+ *
+ * [--top=amount]                              Together with --load, prints the largest directories of the snapshot.
+ *                                             Together with --diff, the amount of directories to print.
+ *
+ * [--diff=file]                               Compares an old snapshot with the paths, which are scanned, or with
+ *                                             the snapshot of --load. Prints the directories that grew or shrunk
+ *                                             the most, with the change in blocks. Default is DIFF_TOP_DEFAULT
+ *                                             directories. The same flags as with --load can't be used, and
+ *                                             neither can -d or --order=path.
+ *
+ * [--checkpoint=file]                         Writes the state of the scan to the file every
+ *                                             CHECKPOINT_DEFAULT_INTERVAL seconds, and when the scan is cancelled or
+ *                                             the deadline passes. The file is removed when the scan is complete.
+ *
+ * [--checkpoint-interval=seconds]             Seconds between two checkpoints. 0 only writes one when the scan stops.
+ *
+ * [--resume]                                  Together with --checkpoint, continues the scan of the same paths from
+ *                                             the checkpoint file, if there is one. Only the directories that are
+ *                                             done after the checkpoint are printed below the roots, so it can't be
+ *                                             used with -o, -s or --diff.
+ *
  * [path] or [paths...]                        One or more paths. The program will calculate the entire depth
- *                                             of the file tree, where the root is the path.
+ *                                             of the file tree, where the root is the path. A path that is inside of
+ *                                             another path, or is given twice, is only read once, as long as only the
+ *                                             paths themselves are printed, and no snapshot is written.
+ *
+ * SIGINT or SIGTERM cancels a scan. The directories that are being read are finished, and the sizes that were
+ * found so far are printed, a lower bound as after the deadline. A second signal ends the program at once.
+ * With --checkpoint, the scan can be continued with --resume.
+ *
+ * The exit status is 0 when every file could be read, 1 when some file couldn't be read or the arguments are
+ * invalid, and 3 (EXIT_CANCELLED) when the scan was cancelled before every directory was read.
  *
  * NOTE! The only argument that is required, is at least one path. Leave the -j flag out, and one thread will do
  * the task.
  *
  * @author  Ludwig Fallström
  * @since   2021-10-14
- * @version 2.0
+ * @version 4.6
  *
  * @{
  */
@@ -28,467 +138,1060 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <unistd.h>
-#include <sys/stat.h>
-#include <pthread.h>
+#include <getopt.h>
+#include <limits.h>
+#include <math.h>
+#include <signal.h>
+#include <pwd.h>
+#include <grp.h>
 #include "string.h"
-#include <dirent.h>
-#include "list.h"
-#include "t_queue.h"
+#include "libmdu.h"
+#include "output.h"
+#include "export.h"
+#include "snapshot.h"
 #include "error_handler.h"
 
-void start_options_and_run(Task_queue *t_queue, List *targets);
-void make_path(char *new_path, const char *name, const char *absolute_path);
-void flag_options(int argc, char *argv[], int *thread_amount);
-List *path_name_parser(int argc, char *const *argv);
-blkcnt_t get_block_size(char *absolute_path, bool *permission);
-void add_task(Task_queue *t_queue, Task *task);
-blkcnt_t get_block_size_mult(Task *task, Task_queue *queue);
-void *run_thread(Task_queue *t_queue);
-void run_task(Task_queue *t_queue, Task *task);
-void run_mult_thread(Task_queue *t_queue, char *start_path);
-blkcnt_t shutdown_threads(Task *task, Task_queue *queue);
-blkcnt_t get_size_of_dir(Task *task, void *queue_or_permission,
-                         const char *absolute_path, struct stat *absolute_path_buf, DIR *dir, bool multithread);
-void kill_task_initializer(Task_queue *t_queue, blkcnt_t temp_block_size, bool queue_empty, int t_running);
+#define DIFF_TOP_DEFAULT 10
+#define ESTIMATE_DEFAULT_RATE 0.1
+#define CONFIDENCE_Z 1.96 //the normal quantile of a 95% confidence interval
+#define CHECKPOINT_DEFAULT_INTERVAL 60
+#define HISTOGRAM_SIZE_BUF 16
+#define AGE_DEFAULT_BOUNDARIES "30d,1y"
+#define EXIT_CANCELLED 3 //the exit status of a scan that was cancelled before it was complete
+
+/**
+ * @brief                  The formats that the program can print in.
+ */
+typedef enum format {
+    FORMAT_TEXT,
+    FORMAT_NDJSON
+} Format;
+
+/**
+ * @brief                  A struct which is the structure for the printing options, given to the callback.
+ *
+ * @elem output            The output that the records are written to.
+ * @elem format            The format of the records.
+ * @elem max_depth         The deepest paths that are printed, 0 for only the roots. -1 until it is set.
+ * @elem all               True if files are printed as well as directories.
+ * @elem sorted            True if the paths of each root are sorted.
+ * @elem export            The export that the scan is written to, instead of printing. NULL if not exporting.
+ * @elem export_path       The path of the export file, "-" for stdout. NULL if not exporting.
+ * @elem snapshot          The snapshot that the scan is written to. NULL if no snapshot is written.
+ * @elem snapshot_path     The path of the snapshot file to write. NULL if no snapshot is written.
+ * @elem load_path         The path of a snapshot file to read instead of scanning. NULL if scanning.
+ * @elem top               Amount of the largest directories to print from the loaded snapshot, or of the
+ *                         directories to print from a diff.
+ * @elem diff_path         The path of an old snapshot to compare with. NULL if not comparing.
+ * @elem histogram         True if the distribution of the file sizes of every root is printed.
+ * @elem owner_key         The owner that files and blocks are printed for. MDU_OWNER_NONE if they aren't printed.
+ * @elem by_type           True if the files and blocks of every file type and extension are printed.
+ * @elem age_buckets       Amount of age buckets that are printed for every path. 0 if ages aren't printed.
+ * @elem age_boundaries    The ages in seconds that separate the age buckets.
+ */
+typedef struct report {
+    Output *output;
+    Format format;
+    int max_depth;
+    bool all;
+    bool sorted;
+    Export *export;
+    const char *export_path;
+    Snapshot_writer *snapshot;
+    const char *snapshot_path;
+    const char *load_path;
+    long top;
+    const char *diff_path;
+    bool histogram;
+    Mdu_owner_key owner_key;
+    bool by_type;
+    int age_buckets;
+    double age_boundaries[MDU_AGE_BUCKETS - 1];
+} Report;
+
+static volatile sig_atomic_t cancelled = 0; //set by the signal handler, read by the workers
+
+void flag_options(int argc, char *argv[], Mdu_options *options, Report *report);
+void print_dir(const Mdu_entry *entry, void *data);
+void print_file(const Mdu_entry *entry, void *data);
+void print_entry(const Mdu_entry *entry, Report *report);
+void save_dir(const Mdu_entry *entry, void *data);
+void save_file(const Mdu_entry *entry, void *data);
+FILE *open_export(const char *export_path);
+bool query_snapshot(Report *report, const char *const *paths, int path_amount);
+void print_snapshot_dir(Report *report, const Snapshot *snapshot, uint64_t index, int depth);
+bool diff_snapshots(Report *report, Mdu_options *options, const char *const *paths, int path_amount,
+                    bool *visited);
+Snapshot *scan_snapshot(Report *report, Mdu_options *options, const char *const *paths, int path_amount,
+                        bool *permission, bool *visited);
+void store_dir(const Mdu_entry *entry, void *data);
+void print_delta(Report *report, const Snapshot *old, const Snapshot *new, const Snapshot_delta *delta);
+bool report_unvisited(const Mdu_result *results, const char *const *paths, int path_amount);
+void report_error(Mdu_error error, const Mdu_options *options);
+void cancel_scan(int signum);
+void handle_cancel(void);
+int exit_status(bool permission, bool visited);
+void report_estimate(const Mdu_result *results, const char *const *paths, int path_amount);
+void print_histograms(Report *report, const Mdu_histogram *histograms, const char *const *paths, int path_amount);
+void format_size(char *buf, size_t length, int exponent);
+void print_ages(const Mdu_entry *entry, Report *report);
+void print_owners(Report *report, const Mdu_owner_table *owners, const char *const *paths, int path_amount);
+const char *owner_name(Mdu_owner_key owner_key, id_t id);
+void print_extensions(Report *report, const Mdu_extension_table *extensions, const char *const *paths,
+                      int path_amount);
+void parse_age_boundaries(const char *ages, Mdu_options *options, Report *report);
+double parse_age(const char *age, char **end);
 
 
 
 int main(int argc, char **argv) {
-    int thread_amount = 1;
-    flag_options(argc, argv, &thread_amount);
-    List *path_names = path_name_parser(argc, argv);
-    Task_queue *t_queue = create_task_queue(thread_amount);
-
-    //the function that starts everything
-    start_options_and_run(t_queue, path_names);
-
-    bool permission = t_queue->permission;
-    list_destroy(path_names);
-    destroy_queue(t_queue);
-    if (permission) { exit(EXIT_SUCCESS); }
-    exit(EXIT_FAILURE);
+    Mdu_options options;
+    Report report = { .output = NULL, .format = FORMAT_TEXT, .max_depth = -1, .all = false, .sorted = false,
+                      .export = NULL, .export_path = NULL, .snapshot = NULL, .snapshot_path = NULL,
+                      .load_path = NULL, .top = 0, .diff_path = NULL, .histogram = false,
+                      .owner_key = MDU_OWNER_NONE, .by_type = false, .age_buckets = 0 };
+    mdu_default_options(&options);
+    options.checkpoint_interval = CHECKPOINT_DEFAULT_INTERVAL;
+    flag_options(argc, argv, &options, &report);
+    if (options.age == MDU_AGE_NONE) {
+        report.age_buckets = 0;
+    } else if (report.age_buckets == 0) {
+        parse_age_boundaries(AGE_DEFAULT_BOUNDARIES, &options, &report);
+    }
+    if (options.age != MDU_AGE_NONE && (report.export_path != NULL || report.load_path != NULL
+                                        || report.diff_path != NULL)) {
+        fprintf(stderr, "mdu: ages can't be printed with --load, --diff or an export\n");
+        exit(EXIT_FAILURE);
+    }
+    if ((report.load_path != NULL || report.diff_path != NULL)
+        && (report.all || report.histogram || report.owner_key != MDU_OWNER_NONE || report.by_type)) {
+        fprintf(stderr, "mdu: -a, --histogram, --by-owner and --by-type can't be used with --load or --diff\n");
+        exit(EXIT_FAILURE);
+    }
+    if (report.diff_path != NULL && (report.max_depth >= 0 || report.sorted)) {
+        fprintf(stderr, "mdu: -d and --order=path can't be used with --diff\n");
+        exit(EXIT_FAILURE);
+    }
+    if (options.resume && options.checkpoint == NULL) {
+        fprintf(stderr, "mdu: --resume needs the file of --checkpoint\n");
+        exit(EXIT_FAILURE);
+    }
+    if (options.resume && (report.export_path != NULL || report.snapshot_path != NULL || report.diff_path != NULL)) {
+        fprintf(stderr, "mdu: a resumed scan can't be exported, or written to a snapshot\n");
+        exit(EXIT_FAILURE);
+    }
+    if (report.histogram && (options.resume || options.sample_rate < 1 || report.export_path != NULL)) {
+        fprintf(stderr, "mdu: a histogram can't be printed for a resumed scan, an estimate or an export\n");
+        exit(EXIT_FAILURE);
+    }
+    if (report.owner_key != MDU_OWNER_NONE && (options.resume || options.sample_rate < 1
+                                               || report.export_path != NULL)) {
+        fprintf(stderr, "mdu: owners can't be printed for a resumed scan, an estimate or an export\n");
+        exit(EXIT_FAILURE);
+    }
+    if (report.by_type && (options.resume || options.sample_rate < 1 || report.export_path != NULL)) {
+        fprintf(stderr, "mdu: file types can't be printed for a resumed scan, an estimate or an export\n");
+        exit(EXIT_FAILURE);
+    }
+    handle_cancel();
+    options.cancel = &cancelled;
+    if (report.max_depth < 0) {
+        report.max_depth = report.all ? INT_MAX : 0;
+    }
+    options.share_roots = report.max_depth == 0 && report.snapshot_path == NULL && report.diff_path == NULL;
+
+    int root_amount = argc - optind;
+    if (report.diff_path != NULL) {
+        bool visited;
+        bool permission = diff_snapshots(&report, &options, (const char *const *)&argv[optind], root_amount,
+                                         &visited);
+        exit(exit_status(permission, visited));
+    }
+    if (report.load_path != NULL) {
+        bool found = query_snapshot(&report, (const char *const *)&argv[optind], root_amount);
+        exit(found ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    FILE *snapshot_file = NULL;
+    if (report.snapshot_path != NULL) {
+        snapshot_file = fopen(report.snapshot_path, "w");
+        error_handler_null(snapshot_file, NULL, (char *)report.snapshot_path, true);
+        report.snapshot = create_snapshot_writer(snapshot_file, mdu_thread_amount(&options));
+    }
+
+    Mdu_result *results = malloc(root_amount * sizeof(Mdu_result));
+    error_handler_null(results, NULL, "Results couldn't be allocated\n",
+                       true);
+    if (report.histogram) {
+        options.histograms = malloc(root_amount * sizeof(Mdu_histogram));
+        error_handler_null(options.histograms, NULL, "Histograms couldn't be allocated\n", true);
+    }
+    if (report.owner_key != MDU_OWNER_NONE) {
+        options.owner_key = report.owner_key;
+        options.owners = malloc(root_amount * sizeof(Mdu_owner_table));
+        error_handler_null(options.owners, NULL, "Owners couldn't be allocated\n", true);
+    }
+    if (report.by_type) {
+        options.extensions = malloc(root_amount * sizeof(Mdu_extension_table));
+        error_handler_null(options.extensions, NULL, "Extensions couldn't be allocated\n", true);
+    }
+
+    //the function that starts everything, the roots are printed or exported through the callbacks
+    bool permission;
+    if (report.export_path != NULL) {
+        if (root_amount != 1) {
+            fprintf(stderr, "mdu: only one path can be exported\n");
+            exit(EXIT_FAILURE);
+        }
+        if (options.sample_rate < 1) {
+            fprintf(stderr, "mdu: an estimate can't be exported\n");
+            exit(EXIT_FAILURE);
+        }
+        FILE *export_file = open_export(report.export_path);
+        report.export = create_export(export_file, mdu_thread_amount(&options));
+        permission = mdu_scan((const char *const *)&argv[optind], root_amount, &options,
+                              save_dir, save_file, &report, results);
+        destroy_export(report.export);
+        error_handler_value(0, fclose(export_file), NULL, "export couldn't be closed", true);
+    } else {
+        report.output = create_output(STDOUT_FILENO, mdu_thread_amount(&options), report.sorted);
+        permission = mdu_scan((const char *const *)&argv[optind], root_amount, &options,
+                              print_dir, report.all ? print_file : NULL, &report, results);
+        destroy_output(report.output);
+    }
+    if (report.snapshot != NULL) {
+        destroy_snapshot_writer(report.snapshot);
+        error_handler_value(0, fclose(snapshot_file), NULL, "snapshot couldn't be closed", true);
+    }
+    if (root_amount > 0 && results[0].error != MDU_ERROR_NONE) {
+        report_error(results[0].error, &options);
+        exit(EXIT_FAILURE);
+    }
+    bool visited = report_unvisited(results, (const char *const *)&argv[optind], root_amount);
+    if (!visited && options.checkpoint != NULL) {
+        fprintf(stderr, "mdu: the scan can be continued with --checkpoint=%s --resume\n", options.checkpoint);
+    }
+    if (options.sample_rate < 1) {
+        report_estimate(results, (const char *const *)&argv[optind], root_amount);
+    }
+    if (report.histogram) {
+        print_histograms(&report, options.histograms, (const char *const *)&argv[optind], root_amount);
+        free(options.histograms);
+    }
+    if (report.owner_key != MDU_OWNER_NONE) {
+        print_owners(&report, options.owners, (const char *const *)&argv[optind], root_amount);
+        for (int i = 0; i < root_amount; i++) {
+            free(options.owners[i].owners);
+        }
+        free(options.owners);
+    }
+    if (report.by_type) {
+        print_extensions(&report, options.extensions, (const char *const *)&argv[optind], root_amount);
+        for (int i = 0; i < root_amount; i++) {
+            free(options.extensions[i].extensions);
+        }
+        free(options.extensions);
+    }
+    free(results);
+    exit(exit_status(permission, visited));
 }
 
 
 /**
- * @brief                                      Chooses if the program will run with multiple threads or not.
+ * @brief                                      Prints a directory that is at most max_depth below it's root.
  *
- *                                             Also goes through the list of paths, and makes sure to
- *                                             run each one of them.
+ *                                             A root is completed after everything inside of it, so every buffer
+ *                                             is written when a root has been added, the buffer with the root
+ *                                             last. That keeps the order of [du], where a directory comes after
+ *                                             the paths inside of it.
  *
- * @param t_queue                              The task queue containing.
- * @param targets                              The list of paths that the size will be calculated upon.
+ * @param entry                                The completed directory.
+ * @param data                                 A pointer to the printing options.
  */
-void start_options_and_run(Task_queue *t_queue, List *targets) {
-    ListPos current_pos = list_first(targets);
-    //loops through the target list
-    while (!list_pos_equal(current_pos, list_end(targets))) {
-        char *path = (char *)list_inspect(current_pos);
-
-        //options if the program will be multithreaded, or done recursively.
-        if (t_queue->thread_amount > 1) {
-            run_mult_thread(t_queue, path);
-        } else {
-            t_queue->block_size = get_block_size(path, &t_queue->permission);
-        }
-        printf("%ld\t%s\n", t_queue->block_size, path);
+void print_dir(const Mdu_entry *entry, void *data) {
+    Report *report = data;
+    if (report->snapshot != NULL) {
+        snapshot_add_dir(report->snapshot, entry);
+    }
+    if (entry->depth > report->max_depth) {
+        return;
+    }
+    print_entry(entry, report);
+    if (entry->depth == 0) {
+        output_flush_all(report->output, entry->worker);
+    }
+}
 
-        //nulls the variables that has been changed
-        t_queue->block_size = 0;
-        t_queue->t_running = 0;
-        t_queue->shutdown = false;
 
-        //clears the queue
-        while (!queue_is_empty(t_queue)) {
-            kill_task(dequeue(t_queue));
-        }
-        current_pos = list_next(current_pos);
+/**
+ * @brief                                      Prints a file that is at most max_depth below it's root. A root
+ *                                             that is a file is printed by print_dir.
+ *
+ * @param entry                                The file.
+ * @param data                                 A pointer to the printing options.
+ */
+void print_file(const Mdu_entry *entry, void *data) {
+    Report *report = data;
+    if (entry->depth == 0 || entry->depth > report->max_depth) {
+        return;
     }
+    print_entry(entry, report);
 }
 
 
 /**
- * @brief                                      The main algorithm for calculating the size recursively.
+ * @brief                                      Formats an entry as a record, into the buffer of the worker that
+ *                                             gave the entry.
  *
- *                                             Calculates the entire depth of the absolute_path parameter.
- *                                             If an error occurred the permission is changed to false.
- *
- *                                             NOTE! That this function is in a recursive call chain
- *
- * @param absolute_paths                       The path that will be the root of the file tree search.
- * @param permission                           A variable that will indicate if an error occurred. False if so.
- * @return                                     Returns the size of the entire file tree, originating in absolute_path.
+ * @param entry                                The entry.
+ * @param report                               The printing options.
  */
-blkcnt_t get_block_size(char *absolute_path, bool *permission) {
-    blkcnt_t block_size = 0;
-    struct stat absolute_path_buf;
-    int check = lstat(absolute_path, &absolute_path_buf);
-    if (check < 0) { return 0; }
-
-    //if dir
-    if (S_ISDIR(absolute_path_buf.st_mode)) {
-        //opens dir
-        DIR *dir = opendir(absolute_path);
-        if (dir == NULL) {
-            fprintf(stderr, "mdu: cannot read directory '%s': Permission denied\n", absolute_path);
-
-            //sets permission to false if the directory is not readable
-            *permission = false;
-            return absolute_path_buf.st_blocks;
-        }
-
-        block_size += get_size_of_dir(NULL, permission, absolute_path, &absolute_path_buf, dir, false);
+void print_entry(const Mdu_entry *entry, Report *report) {
+    Output *output = report->output;
+    output_begin_record(output, entry->worker, entry->path);
+    if (report->format == FORMAT_NDJSON) {
+        output_printf(output, entry->worker, "{\"path\":");
+        output_json_string(output, entry->worker, entry->path);
+        output_printf(output, entry->worker,
+                      ",\"blocks\":%ld,\"bytes\":%ld,\"files\":%ld,\"dirs\":%ld,\"errors\":%ld,"
+                      "\"unvisited\":%ld,\"ci95\":%ld,\"depth\":%d,\"duration\":%.6f",
+                      (long)entry->totals.block_size, (long)entry->totals.bytes, entry->totals.file_amount,
+                      entry->totals.dir_amount, entry->totals.error_amount, entry->totals.unvisited_amount,
+                      lround(CONFIDENCE_Z * sqrt(entry->totals.variance)), entry->depth, entry->duration);
+        print_ages(entry, report);
+        output_printf(output, entry->worker, "}\n");
     } else {
-        block_size += absolute_path_buf.st_blocks;
+        output_printf(output, entry->worker, "%ld\t", (long)entry->totals.block_size);
+        print_ages(entry, report);
+        output_printf(output, entry->worker, "%s\n", entry->path);
     }
-    return block_size;
+    output_end_record(output, entry->worker);
 }
 
 
 /**
- * @brief                                      The main algorithm for calculating the size with multiple threads.
- *
- *                                             Calculates the size of the path.
- *                                             If it's a file, the file size will be returned.
- *                                             If it's a directory, the size of it's contents will be
- *                                             returned. And the paths to directories will be added to
- *                                             the task queue.
- *                                             If an error occurred the permission is changed to false.
- *
- * @param task                                 A task containing a path that the size will be calculated upon.
- * @param queue                                A task queue, containing settings, and for being added toı
- * @return                                     Returns the size of the path contained in the task.
+ * @brief                                      Formats the blocks of every age bucket of an entry, as columns in
+ *                                             text, and as an array of the upper age and blocks of every bucket in
+ *                                             ndjson. Nothing is formatted when ages aren't printed.
+ *
+ * @param entry                                The entry.
+ * @param report                               The printing options.
  */
-blkcnt_t get_block_size_mult(Task *task, Task_queue *queue) {
-    blkcnt_t block_size = 0;
-    char *absolute_path = task->path;
-    struct stat absolute_path_buf;
-    int check = lstat(absolute_path, &absolute_path_buf);
-    if (check < 0) {
-        return 0;
-    }
-
-    //if dir
-    if (S_ISDIR(absolute_path_buf.st_mode)) {
-        //opens dir
-        DIR *dir = opendir(absolute_path);
-        if (dir == NULL) {
-            fprintf(stderr, "mdu: cannot read directory '%s': Permission denied\n", absolute_path);
-            pthread_mutex_lock(&queue->mutex);
-            queue->permission = false;
-            pthread_mutex_unlock(&queue->mutex);
-            return absolute_path_buf.st_blocks;
+void print_ages(const Mdu_entry *entry, Report *report) {
+    if (report->age_buckets == 0) {
+        return;
+    }
+    if (report->format == FORMAT_NDJSON) {
+        output_printf(report->output, entry->worker, ",\"ages\":[");
+    }
+    for (int i = 0; i < report->age_buckets; i++) {
+        long blocks = (long)entry->totals.age_block_size[i];
+        if (report->format == FORMAT_NDJSON && i < report->age_buckets - 1) {
+            output_printf(report->output, entry->worker, "{\"max\":%.0f,\"blocks\":%ld},",
+                          report->age_boundaries[i], blocks);
+        } else if (report->format == FORMAT_NDJSON) {
+            output_printf(report->output, entry->worker, "{\"max\":null,\"blocks\":%ld}]", blocks);
+        } else {
+            output_printf(report->output, entry->worker, "%ld\t", blocks);
         }
-        block_size = get_size_of_dir(task, queue, absolute_path, &absolute_path_buf, dir, true);
-    } else {
-        block_size += absolute_path_buf.st_blocks;
     }
-    return block_size;
 }
 
 
 /**
- * @brief                                      The main algorithm for going through a directory and calculating it's
- *                                             contents total size.
+ * @brief                                      Adds a completed directory to the export.
  *
- *                                             In multithreading mode, tasks will be added to the task queue, if
- *                                             new directories inside is found. In recursive mode, the get_block_size
- *                                             function will be called with the new path to a directory.
+ * @param entry                                The completed directory.
+ * @param data                                 A pointer to the printing options.
+ */
+void save_dir(const Mdu_entry *entry, void *data) {
+    Report *report = data;
+    if (report->snapshot != NULL) {
+        snapshot_add_dir(report->snapshot, entry);
+    }
+    export_dir(report->export, entry);
+}
+
+
+/**
+ * @brief                                      Adds a file to the export.
  *
- * @param task                                 A task containing a function pointer, which will be used to create
- *                                             a new task. Set to NUll if the program should be used with one thread.
+ * @param entry                                The file.
+ * @param data                                 A pointer to the printing options.
+ */
+void save_file(const Mdu_entry *entry, void *data) {
+    export_file(((Report *)data)->export, entry);
+}
+
+
+/**
+ * @brief                                      Opens the export file for writing.
  *
- * @param queue_or_permission                  Takes either a pointer to a queue, or a boolean. A queue if it is
- *                                             multithreaded, Otherwise a boolean which holds an indication if
- *                                             there was an error.
+ * @param export_path                          The path of the export file, "-" for stdout.
+ * @return                                     The opened file.
+ */
+FILE *open_export(const char *export_path) {
+    if (strcmp(export_path, "-") == 0) {
+        return stdout;
+    }
+    FILE *file = fopen(export_path, "w");
+    error_handler_null(file, NULL, (char *)export_path, true);
+    return file;
+}
+
+
+/**
+ * @brief                                      Prints directories from a snapshot instead of scanning.
  *
- * @param absolute_path                        The path to the directory. Will be used when creating new path names.
- * @param absolute_path_buf                    A struct stat which holds information of the absolute_path.
- * @param dir                                  A pointer to an opened directory.
- * @param multithread                          Set to true, if it should be used with multithreading.
- * @return                                     Returns the size of a directory.
+ * @param report                               The printing options, with the path of the snapshot.
+ * @param paths                                The paths that are looked up in the snapshot.
+ * @param path_amount                          Amount of paths. The roots are printed if it's 0, and no top
+ *                                             directories are asked for.
+ * @return                                     False if some path wasn't in the snapshot.
  */
-blkcnt_t get_size_of_dir(Task *task, void *queue_or_permission,
-                         const char *absolute_path, struct stat *absolute_path_buf, DIR *dir, bool multithread) {
-    blkcnt_t block_size = 0;
-    struct dirent *dir_struct;
-    char *new_absolute_path;
-    //if directory has content
-    while ((dir_struct = readdir(dir)) != NULL) {
-        //allocates memory for new path
-        new_absolute_path = malloc(CHAR_BUF * sizeof(char));
-        error_handler_null(new_absolute_path, NULL, "Memory for new path couldn't be allocated",
-                           true);
-        make_path(new_absolute_path, dir_struct->d_name, absolute_path);
-
-        struct stat new_absolute_path_buf;
-        int check = lstat(new_absolute_path, &new_absolute_path_buf);
-
-        /**
-         * if path is not readable, size of current directory is added.
-         * As soon as the new absolute path wont be a part of a new task it gets free'd
-         */
-        if ((check < 0)) {
-            block_size += (*absolute_path_buf).st_blocks;
-            free(new_absolute_path);
-            break;
-        }
-        else if (strcmp(dir_struct->d_name, ".") == 0) {
-            block_size += new_absolute_path_buf.st_blocks;
-            free(new_absolute_path);
+bool query_snapshot(Report *report, const char *const *paths, int path_amount) {
+    bool found = true;
+    Snapshot *snapshot = load_snapshot(report->load_path);
+    report->output = create_output(STDOUT_FILENO, 1, report->sorted);
+
+    for (int i = 0; i < path_amount; i++) {
+        int64_t index = snapshot_find(snapshot, paths[i]);
+        if (index < 0) {
+            fprintf(stderr, "mdu: '%s' isn't in the snapshot\n", paths[i]);
+            found = false;
+            continue;
         }
-        else if (strcmp(dir_struct->d_name, "..") != 0) {
-            //if path is a file
-            if (S_ISREG(new_absolute_path_buf.st_mode)) {
-                block_size += new_absolute_path_buf.st_blocks;
-                free(new_absolute_path);
-            }
-            //if path is a directory
-            else {
-                //adds to task queue
-                if(multithread) {
-                    Task *new_task = create_task(new_absolute_path, (void (*)(struct task *,
-                            Task_queue *)) (void (*)(void)) task->task_pointer);
-                    add_task((Task_queue *)queue_or_permission, new_task);
-                } else {
-                    block_size += get_block_size(new_absolute_path, (bool *)queue_or_permission);
-                    free(new_absolute_path);
-                }
-            }
+        print_snapshot_dir(report, snapshot, index, 0);
+        output_flush_all(report->output, 0);
+    }
+    if (report->top > 0) {
+        uint64_t top_amount;
+        uint64_t *top = snapshot_top(snapshot, report->top, &top_amount);
+        for (uint64_t i = 0; i < top_amount; i++) {
+            print_snapshot_dir(report, snapshot, top[i], report->max_depth);
         }
-        else {
-            free(new_absolute_path);
+        free(top);
+    } else if (path_amount == 0) {
+        for (uint64_t i = 0; i < snapshot->header->root_amount; i++) {
+            print_snapshot_dir(report, snapshot, i, 0);
         }
     }
-    error_handler_value(0, closedir(dir), "Couldn't close directory\n",
-                        NULL, false);
-    return block_size;
+
+    destroy_output(report->output);
+    unload_snapshot(snapshot);
+    return found;
 }
 
 
 /**
- * @brief                                      Responsible for telling the threadpool to shutdown.
- *
- *                                             Doesn't do much apart from changing the task queues shutdown variable
- *                                             to true.
+ * @brief                                      Prints a directory from a snapshot, after the directories inside of
+ *                                             it that are at most max_depth below it.
  *
- * @param task                                 A task where the pathname will be set to NULL.
- * @param queue                                A pointer to a task queue, containing the shutdown variable.
- * @return                                     Returns -1 indicating that this function is only for shutting down.
+ * @param report                               The printing options.
+ * @param snapshot                             The snapshot.
+ * @param index                                The index of the directory's record.
+ * @param depth                                How far below the printed path the directory is.
  */
-blkcnt_t shutdown_threads(Task *task, Task_queue *queue) {
-    pthread_mutex_lock(&queue->mutex);
-    queue->shutdown = true;
-    task->path = NULL;
-    pthread_mutex_unlock(&queue->mutex);
-    return -1;
+void print_snapshot_dir(Report *report, const Snapshot *snapshot, uint64_t index, int depth) {
+    if (depth < report->max_depth) {
+        uint64_t first;
+        uint64_t amount = snapshot_children(snapshot, index, &first);
+        for (uint64_t i = first; i < first + amount; i++) {
+            print_snapshot_dir(report, snapshot, i, depth + 1);
+        }
+    }
+    const Snapshot_record *record = &snapshot->records[index];
+    char *path = snapshot_path(snapshot, index);
+    Mdu_entry entry = { .path = path, .stat = NULL, .depth = record->depth, .worker = 0,
+                        .totals = { .block_size = record->block_size, .bytes = record->bytes,
+                                    .file_amount = record->file_amount, .dir_amount = record->dir_amount,
+                                    .error_amount = record->error_amount } };
+    print_entry(&entry, report);
+    free(path);
 }
 
 
 /**
- * @brief                                      Parses flags that has been arguments to the program. If -j
- *                                             flag is set, an integer indicating the thread amount is also used.
+ * @brief                                      Compares an old snapshot with a loaded snapshot, or with a scan of
+ *                                             the paths, and prints the directories that changed the most.
  *
- * @param argc                                 Amount of parameters to the program.
- * @param argv                                 Array of strings, containing the names of the arguments.
- * @param thread_amount                        Pointer to an integer for containing the amount of threads.
+ * @param report                               The printing options, with the paths of the snapshots.
+ * @param options                              The options of the scan.
+ * @param paths                                The paths that are scanned, if no snapshot is loaded.
+ * @param path_amount                          Amount of paths.
+ * @param visited                              Where false is stored if some directory wasn't read by the scan.
+ * @return                                     False if some file couldn't be read by the scan.
  */
-void flag_options(int argc, char *argv[], int *thread_amount) {
-    int option;
-    while ((option = getopt(argc, argv, "j:")) != -1) {
-        switch (option) {
-            case 'j':
-                *thread_amount = atoi(optarg);
-                break;
-            default:
-                break;
-        }
+bool diff_snapshots(Report *report, Mdu_options *options, const char *const *paths, int path_amount,
+                    bool *visited) {
+    bool permission = true;
+    *visited = true;
+    Snapshot *old = load_snapshot(report->diff_path);
+    Snapshot *new;
+    if (report->load_path != NULL) {
+        new = load_snapshot(report->load_path);
+    } else {
+        new = scan_snapshot(report, options, paths, path_amount, &permission, visited);
+    }
+
+    uint64_t amount;
+    Snapshot_delta *deltas = snapshot_diff(old, new, report->top > 0 ? report->top : DIFF_TOP_DEFAULT, &amount);
+    report->output = create_output(STDOUT_FILENO, 1, false);
+    for (uint64_t i = 0; i < amount; i++) {
+        print_delta(report, old, new, &deltas[i]);
     }
+    destroy_output(report->output);
+    free(deltas);
+    unload_snapshot(new);
+    unload_snapshot(old);
+    return permission;
 }
 
 
 /**
- * @brief                                      Responsible for adding a task to the task queue, and signaling the
- *                                             threadpool when this has occurred.
+ * @brief                                      Scans the paths into a snapshot, and loads it. The snapshot is
+ *                                             written to the snapshot file if there is one, and otherwise to a
+ *                                             temporary file.
  *
- * @param t_queue                              Pointer to a task queue.
- * @param task                                 Pointer to the task that will be added.
+ * @param report                               The printing options.
+ * @param options                              The options of the scan.
+ * @param paths                                The paths that are scanned.
+ * @param path_amount                          Amount of paths.
+ * @param permission                           Where false is stored if some file couldn't be read.
+ * @param visited                              Where false is stored if some directory wasn't read.
+ * @return                                     The snapshot of the scan.
  */
-void add_task(Task_queue *t_queue, Task *task) {
-    pthread_mutex_lock(&t_queue->mutex);
-    enqueue(t_queue, task);
-    int check_signal = pthread_cond_signal(&t_queue->cond);
-    error_handler_value(0, check_signal, NULL, "Error! cond_signal failed\n",
-                        false);
-    pthread_mutex_unlock(&t_queue->mutex);
+Snapshot *scan_snapshot(Report *report, Mdu_options *options, const char *const *paths, int path_amount,
+                        bool *permission, bool *visited) {
+    const char *snapshot_path = report->snapshot_path != NULL ? report->snapshot_path : "temporary snapshot";
+    FILE *file = report->snapshot_path != NULL ? fopen(report->snapshot_path, "w+") : tmpfile();
+    error_handler_null(file, NULL, (char *)snapshot_path, true);
+    report->snapshot = create_snapshot_writer(file, mdu_thread_amount(options));
+
+    Mdu_result *results = malloc(path_amount * sizeof(Mdu_result));
+    error_handler_null(results, NULL, "Results couldn't be allocated\n",
+                       true);
+    *permission = mdu_scan(paths, path_amount, options, store_dir, NULL, report, results);
+    *visited = report_unvisited(results, paths, path_amount);
+    free(results);
+
+    destroy_snapshot_writer(report->snapshot);
+    report->snapshot = NULL;
+    error_handler_value(0, fflush(file), NULL, (char *)snapshot_path, true);
+    Snapshot *snapshot = load_snapshot_fd(dup(fileno(file)), snapshot_path);
+    error_handler_value(0, fclose(file), NULL, "snapshot couldn't be closed", true);
+    return snapshot;
 }
 
 
 /**
- * @brief                                      Responsible for running the threads, the main function of the
- *                                             threadpool.
+ * @brief                                      Adds a completed directory to the snapshot, without printing it.
  *
- *                                             When no task is in the queue, the threads wait for a condition variable
- *                                             to be signalled when a new task has been added.
+ * @param entry                                The completed directory.
+ * @param data                                 A pointer to the printing options.
+ */
+void store_dir(const Mdu_entry *entry, void *data) {
+    snapshot_add_dir(((Report *)data)->snapshot, entry);
+}
+
+
+/**
+ * @brief                                      Prints how much a directory changed between two snapshots. The
+ *                                             path is taken from the new snapshot, or from the old if the
+ *                                             directory is gone.
  *
- * @param t_queue                              The task queue that the threadpool gets it's tasks from.
- * @return                                     returns NULL.
+ * @param report                               The printing options.
+ * @param old                                  The old snapshot.
+ * @param new                                  The new snapshot.
+ * @param delta                                The change of the directory.
  */
-void *run_thread(Task_queue *t_queue) {
+void print_delta(Report *report, const Snapshot *old, const Snapshot *new, const Snapshot_delta *delta) {
+    const Snapshot_record *old_record = delta->old_index >= 0 ? &old->records[delta->old_index] : NULL;
+    const Snapshot_record *new_record = delta->new_index >= 0 ? &new->records[delta->new_index] : NULL;
+    char *path = new_record != NULL ? snapshot_path(new, delta->new_index) : snapshot_path(old, delta->old_index);
+    Output *output = report->output;
+    output_begin_record(output, 0, path);
+    if (report->format == FORMAT_NDJSON) {
+        output_printf(output, 0, "{\"path\":");
+        output_json_string(output, 0, path);
+        output_printf(output, 0, ",\"blocks\":%ld,\"old_blocks\":%ld,\"delta\":%ld,\"bytes_delta\":%ld}\n",
+                      new_record != NULL ? (long)new_record->block_size : 0L,
+                      old_record != NULL ? (long)old_record->block_size : 0L, (long)delta->delta,
+                      (long)((new_record != NULL ? new_record->bytes : 0)
+                             - (old_record != NULL ? old_record->bytes : 0)));
+    } else {
+        output_printf(output, 0, "%+ld\t%s\n", (long)delta->delta, path);
+    }
+    output_end_record(output, 0);
+    free(path);
+}
 
-    pthread_mutex_lock(&t_queue->mutex);
-    //loops until a kill task has been added to the queue
-    while (!t_queue->shutdown) {
 
-        //the threads wait here until a task has been added, and a signal is sent
-        while (queue_is_empty(t_queue)) {
-            int check_wait = pthread_cond_wait(&t_queue->cond, &t_queue->mutex);
-            error_handler_value(0, check_wait, NULL, "Error! cond_wait failed\n",
-                                false);
+/**
+ * @brief                                      Prints how many directories of every root that weren't read,
+ *                                             because the scan was cancelled or the deadline passed.
+ *
+ * @param results                              The results of the roots.
+ * @param paths                                The paths of the roots.
+ * @param path_amount                          Amount of roots.
+ * @return                                     False if some directory wasn't read.
+ */
+bool report_unvisited(const Mdu_result *results, const char *const *paths, int path_amount) {
+    bool visited = true;
+    for (int i = 0; i < path_amount; i++) {
+        if (results[i].totals.unvisited_amount > 0) {
+            fprintf(stderr, "mdu: %s, %ld directories in '%s' weren't read\n",
+                    cancelled ? "scan cancelled" : "deadline passed", results[i].totals.unvisited_amount,
+                    paths[i]);
+            visited = false;
         }
-        //dequeues and runs a task
-        Task *task = dequeue(t_queue);
-        t_queue->t_running++;
-        pthread_mutex_unlock(&t_queue->mutex);
-        run_task(t_queue, task);
-        pthread_mutex_lock(&t_queue->mutex);
-        kill_task(task);
-    }
-    pthread_mutex_unlock(&t_queue->mutex);
-    return NULL;
+    }
+    return visited;
 }
 
 
 /**
- * @brief                                      Responsible for starting a task.
+ * @brief                                      Gives the exit status of the program. A lower bound because of a
+ *                                             deadline is what was asked for, so only a scan that was cancelled
+ *                                             before it was complete gets EXIT_CANCELLED.
  *
- *                                             Runs the function pointed to, which is contained in the task.
- *                                             Also adds the block size returned onto the common block_size variable.
- *
- * @param t_queue                              The task queue which also contains settings.
- * @param task                                 The task that will run.
+ * @param permission                           False if some file couldn't be read.
+ * @param visited                              False if some directory wasn't read.
+ * @return                                     EXIT_CANCELLED, EXIT_FAILURE or EXIT_SUCCESS.
  */
-void run_task(Task_queue *t_queue, Task *task) {
-    blkcnt_t temp_block_size;
-    //make sure that the function pointed to is not inside of a mutex
-    temp_block_size = task->task_pointer(task, t_queue);
-    pthread_mutex_lock(&t_queue->mutex);
+int exit_status(bool permission, bool visited) {
+    if (!visited && cancelled) {
+        return EXIT_CANCELLED;
+    }
+    return permission ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 
-    //checks if the task that has been run is a kill-task or a regular
-    if (temp_block_size > -1) {
-        t_queue->block_size += temp_block_size;
+/**
+ * @brief                                      Prints why a scan couldn't start.
+ *
+ * @param error                                The error of the scan.
+ * @param options                              The options of the scan, with the path of the checkpoint.
+ */
+void report_error(Mdu_error error, const Mdu_options *options) {
+    if (error == MDU_ERROR_CHECKPOINT_ROOTS) {
+        fprintf(stderr, "mdu: '%s' is a checkpoint of other paths\n", options->checkpoint);
+    } else {
+        fprintf(stderr, "mdu: '%s' isn't a checkpoint that can be read\n", options->checkpoint);
     }
-    t_queue->t_running--;
+}
+
+
+/**
+ * @brief                                      Cancels the scan when SIGINT or SIGTERM is received.
+ *
+ * @param signum                               The number of the received signal.
+ */
+void cancel_scan(int signum) {
+    (void)signum;
+    __atomic_store_n(&cancelled, 1, __ATOMIC_RELAXED);
+}
 
-    bool queue_empty = queue_is_empty(t_queue);
-    int t_running = t_queue->t_running;
 
-    pthread_mutex_unlock(&t_queue->mutex);
-    kill_task_initializer(t_queue, temp_block_size, queue_empty, t_running);
+/**
+ * @brief                                      Makes SIGINT and SIGTERM cancel the scan. The handler is reset
+ *                                             when it's called, so a second signal ends the program.
+ */
+void handle_cancel(void) {
+    struct sigaction action;
+    action.sa_handler = cancel_scan;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART | SA_RESETHAND;
+    error_handler_value(0, sigaction(SIGINT, &action, NULL), NULL, "sigaction", true);
+    error_handler_value(0, sigaction(SIGTERM, &action, NULL), NULL, "sigaction", true);
+}
+
 
+/**
+ * @brief                                      Prints the estimated blocks of every root, with the 95% confidence
+ *                                             interval.
+ *
+ * @param results                              The results of the roots.
+ * @param paths                                The paths of the roots.
+ * @param path_amount                          Amount of roots.
+ */
+void report_estimate(const Mdu_result *results, const char *const *paths, int path_amount) {
+    for (int i = 0; i < path_amount; i++) {
+        long estimate = (long)results[i].totals.block_size;
+        long interval = lround(CONFIDENCE_Z * sqrt(results[i].totals.variance));
+        //a size is never negative, even if the interval is wider than the estimate
+        long lower = estimate > interval ? estimate - interval : 0;
+        fprintf(stderr, "mdu: estimate of '%s' is %ld blocks, between %ld and %ld at 95%% confidence\n",
+                paths[i], estimate, lower, estimate + interval);
+    }
 }
 
 
 /**
- * @brief                                      Creates tasks for shutting down the threadpool.
+ * @brief                                      Prints the distribution of the file sizes of every root, one line for
+ *                                             every bucket that has files in it.
  *
- * @param t_queue                              Pointer to a task queue.
- * @param temp_block_size                      Makes sure that killing tasks only can be made from a regular task.
- * @param queue_empty                          True if the queue is empty.
- * @param t_running                            Amount of threads in the threadpool currently doing work.
+ * @param report                               The printing options.
+ * @param histograms                           The histograms of the roots.
+ * @param paths                                The paths of the roots.
+ * @param path_amount                          Amount of roots.
  */
-void kill_task_initializer(Task_queue *t_queue, blkcnt_t temp_block_size, bool queue_empty, int t_running) {
-    if ( queue_empty && (t_running == 0) && (temp_block_size > -1) ) {
-        //creates the same amount of kill threads as thread amount
-        for (int i = 0; i < t_queue->thread_amount; i++) {
-            Task *new_task = create_task(NULL,
-                                         (void (*)(struct task *, Task_queue *)) (void (*)(void)) shutdown_threads);
-            add_task(t_queue, new_task);
+void print_histograms(Report *report, const Mdu_histogram *histograms, const char *const *paths, int path_amount) {
+    char lower[HISTOGRAM_SIZE_BUF];
+    char upper[HISTOGRAM_SIZE_BUF];
+    report->output = create_output(STDOUT_FILENO, 1, false);
+    for (int i = 0; i < path_amount; i++) {
+        for (int j = 0; j < MDU_HISTOGRAM_BUCKETS; j++) {
+            if (histograms[i].file_amount[j] == 0) {
+                continue;
+            }
+            output_begin_record(report->output, 0, paths[i]);
+            if (report->format == FORMAT_NDJSON) {
+                output_printf(report->output, 0, "{\"type\":\"histogram\",\"path\":");
+                output_json_string(report->output, 0, paths[i]);
+                output_printf(report->output, 0, ",\"min\":%llu,\"max\":%llu,\"files\":%ld,\"blocks\":%ld}\n",
+                              j == 0 ? 0ULL : 1ULL << (j - 1), 1ULL << j, histograms[i].file_amount[j],
+                              (long)histograms[i].block_size[j]);
+            } else {
+                format_size(lower, sizeof(lower), j - 1);
+                format_size(upper, sizeof(upper), j);
+                output_printf(report->output, 0, "%ld\t%ld\t[%s, %s)\t%s\n", histograms[i].file_amount[j],
+                              (long)histograms[i].block_size[j], lower, upper, paths[i]);
+            }
+            output_end_record(report->output, 0);
         }
     }
+    destroy_output(report->output);
 }
 
 
 /**
- * @brief                                      Starts the threadpool, adds the first task, and joins all of the threads
- *                                             when done.
+ * @brief                                      Prints the blocks and files of every owner of every root, with the
+ *                                             owner of the most blocks of a root first.
  *
- * @param t_queue                              Pointer to a task queue.
- * @param start_path                           Name of the start path.
+ * @param report                               The printing options.
+ * @param owners                               The owners of the roots.
+ * @param paths                                The paths of the roots.
+ * @param path_amount                          Amount of roots.
  */
-void run_mult_thread(Task_queue *t_queue, char *start_path) {
-    pthread_t threads[t_queue->thread_amount];
+void print_owners(Report *report, const Mdu_owner_table *owners, const char *const *paths, int path_amount) {
+    report->output = create_output(STDOUT_FILENO, 1, false);
+    for (int i = 0; i < path_amount; i++) {
+        for (long j = 0; j < owners[i].owner_amount; j++) {
+            const Mdu_owner *owner = &owners[i].owners[j];
+            const char *name = owner_name(report->owner_key, owner->id);
+            output_begin_record(report->output, 0, paths[i]);
+            if (report->format == FORMAT_NDJSON) {
+                output_printf(report->output, 0, "{\"type\":\"owner\",\"path\":");
+                output_json_string(report->output, 0, paths[i]);
+                output_printf(report->output, 0, ",\"%s\":%lu,\"name\":",
+                              report->owner_key == MDU_OWNER_UID ? "uid" : "gid", (unsigned long)owner->id);
+                if (name != NULL) {
+                    output_json_string(report->output, 0, name);
+                } else {
+                    output_printf(report->output, 0, "null");
+                }
+                output_printf(report->output, 0, ",\"files\":%ld,\"blocks\":%ld}\n", owner->file_amount,
+                              (long)owner->block_size);
+            } else if (name != NULL) {
+                output_printf(report->output, 0, "%ld\t%ld\t%s\t%s\n", (long)owner->block_size,
+                              owner->file_amount, name, paths[i]);
+            } else {
+                output_printf(report->output, 0, "%ld\t%ld\t%lu\t%s\n", (long)owner->block_size,
+                              owner->file_amount, (unsigned long)owner->id, paths[i]);
+            }
+            output_end_record(report->output, 0);
+        }
+    }
+    destroy_output(report->output);
+}
 
-    //creates the threads
-    for (int i = 0; i < t_queue->thread_amount; i++) {
-        int pthread_create_check = pthread_create(&threads[i], NULL, (void *(*)(void *)) run_thread, t_queue);
-        error_handler_value(0, pthread_create_check, "Error! Couldn't create thread: ",
-                            (char *) threads[i],false);
+
+/**
+ * @brief                                      Looks up the name of a user or a group.
+ *
+ * @param owner_key                            MDU_OWNER_UID for a user, MDU_OWNER_GID for a group.
+ * @param id                                   The user or group id.
+ * @return                                     The name, valid until the next lookup. NULL if the id has no name.
+ */
+const char *owner_name(Mdu_owner_key owner_key, id_t id) {
+    if (owner_key == MDU_OWNER_UID) {
+        struct passwd *user = getpwuid(id);
+        return user != NULL ? user->pw_name : NULL;
     }
+    struct group *group = getgrgid(id);
+    return group != NULL ? group->gr_name : NULL;
+}
+
+
+/**
+ * @brief                                      Prints the blocks and files of every file type and extension of
+ *                                             every root, with the most blocks of a root first.
+ *
+ * @param report                               The printing options.
+ * @param extensions                           The file types and extensions of the roots.
+ * @param paths                                The paths of the roots.
+ * @param path_amount                          Amount of roots.
+ */
+void print_extensions(Report *report, const Mdu_extension_table *extensions, const char *const *paths,
+                      int path_amount) {
+    static const char *const type_names[] = { "regular", "symlink", "socket", "fifo", "device", "other" };
+    report->output = create_output(STDOUT_FILENO, 1, false);
+    for (int i = 0; i < path_amount; i++) {
+        for (long j = 0; j < extensions[i].extension_amount; j++) {
+            const Mdu_extension *extension = &extensions[i].extensions[j];
+            output_begin_record(report->output, 0, paths[i]);
+            if (report->format == FORMAT_NDJSON) {
+                output_printf(report->output, 0, "{\"type\":\"extension\",\"path\":");
+                output_json_string(report->output, 0, paths[i]);
+                output_printf(report->output, 0, ",\"file_type\":\"%s\",\"extension\":",
+                              type_names[extension->type]);
+                output_json_string(report->output, 0, extension->extension);
+                output_printf(report->output, 0, ",\"files\":%ld,\"blocks\":%ld}\n", extension->file_amount,
+                              (long)extension->block_size);
+            } else {
+                output_printf(report->output, 0, "%ld\t%ld\t%s\t%s%s\t%s\n", (long)extension->block_size,
+                              extension->file_amount, type_names[extension->type],
+                              extension->extension[0] == '\0' ? "-" : ".", extension->extension, paths[i]);
+            }
+            output_end_record(report->output, 0);
+        }
+    }
+    destroy_output(report->output);
+}
 
-    //start task
-    char *path = malloc(CHAR_BUF * sizeof(char));
-    error_handler_null(path, NULL, "Couldn't allocate memory for start task\n",
-                       true);
-    strcpy(path, start_path);
-    Task *start_task = create_task(path, (void (*)(struct task *, Task_queue *)) (void (*)(void)) get_block_size_mult);
-    add_task(t_queue, start_task);
 
-    //join threads
-    for (int i = 0; i < t_queue->thread_amount; i++) {
-        int pthread_join_check = pthread_join(threads[i], NULL);
-        error_handler_value(0, pthread_join_check, "Could not join thread: ",
-                            (char *) threads[i], false);
+/**
+ * @brief                                      Formats a power of 2 as a size in bytes, with a binary prefix when
+ *                                             it's 1024 or more, such as 4K for 2^12.
+ *
+ * @param buf                                  Where the size is written.
+ * @param length                               Amount of bytes that there is room for in buf.
+ * @param exponent                             The exponent of the power of 2. -1 for a size of 0.
+ */
+void format_size(char *buf, size_t length, int exponent) {
+    if (exponent < 0) {
+        snprintf(buf, length, "0");
+        return;
     }
+    static const char *const prefixes[] = { "", "K", "M", "G", "T", "P", "E" };
+    snprintf(buf, length, "%d%s", 1 << (exponent % 10), prefixes[exponent / 10]);
 }
 
 
 /**
- * @brief                                      Parses path names that has been arguments to the program.
+ * @brief                                      Parses the ages that separate the age buckets, and gives them to the
+ *                                             scan. Exits if an age is invalid, or the ages aren't ascending.
  *
- * @param argc                                 Amount of arguments to the program.
- * @param argv                                 Array of strings containing the name of the program arguments.
- * @return                                     Pointer to a dynamically allocated list containing path names.
+ * @param ages                                 The ages, separated by commas.
+ * @param options                              The options of the scan.
+ * @param report                               The printing options, where the ages are stored.
  */
-List *path_name_parser(int argc, char *const *argv) {
-    List *path_name_list = list_create();
-    while (optind < argc) {
-        ListPos last_pos = list_end(path_name_list);
-        char *path_name = malloc(CHAR_BUF * sizeof(char));
-        error_handler_null(path_name, NULL, "Path name couldn't be allocated\n",
-                           true);
-        strcpy(path_name, argv[optind]);
-        list_insert(last_pos, path_name);
-        optind++;
-    }
-    return path_name_list;
+void parse_age_boundaries(const char *ages, Mdu_options *options, Report *report) {
+    int amount = 0;
+    const char *age = ages;
+    char *end;
+    do {
+        double seconds = parse_age(age, &end);
+        if (seconds < 0 || (*end != ',' && *end != '\0') || amount == MDU_AGE_BUCKETS - 1
+            || (amount > 0 && seconds <= report->age_boundaries[amount - 1])) {
+            fprintf(stderr, "mdu: invalid age buckets '%s', expected at most %d ascending ages such as 30d,1y\n",
+                    ages, MDU_AGE_BUCKETS - 1);
+            exit(EXIT_FAILURE);
+        }
+        report->age_boundaries[amount++] = seconds;
+        age = end + 1;
+    } while (*end == ',');
+    report->age_buckets = amount + 1;
+    options->age_boundaries = report->age_boundaries;
+    options->age_boundary_amount = amount;
 }
 
 
 /**
- * @brief                                      Adds a path onto another path name, and stores it in new_path.
+ * @brief                                      Parses one age, a number with a unit of s, h, d, w or y after it,
+ *                                             or days without a unit.
  *
- * @param new_path                             An empty buffer where the two path names will be added to.
- * @param name                                 The path name that will be added to the absolute_path.
- * @param absolute_path                        The path that the name will be added onto.
+ * @param age                                  The age.
+ * @param end                                  Set to the first character after the age.
+ * @return                                     The age in seconds, or -1 if it isn't a valid age.
  */
-void make_path(char *new_path, const char *name, const char *absolute_path) {
-    int i = 0;
-    int j = 0;
-    while (absolute_path[i] != '\0') {
-        new_path[i] = absolute_path[i];
-        i++;
-    }
-    if (absolute_path[i - 1] != '/') {
-        new_path[i] = '/';
-        i++;
-    }
-    while (name[j] != '\0') {
-        new_path[i] = name[j];
-        i++;
-        j++;
-    }
-    new_path[i] = '\0';
+double parse_age(const char *age, char **end) {
+    double number = strtod(age, end);
+    if (*end == age || number < 0) {
+        return -1;
+    }
+    switch (**end) {
+        case 's':
+            (*end)++;
+            return number;
+        case 'h':
+            (*end)++;
+            return number * 3600;
+        case 'w':
+            (*end)++;
+            return number * 7 * 86400;
+        case 'y':
+            (*end)++;
+            return number * 365 * 86400;
+        case 'd':
+            (*end)++;
+            return number * 86400;
+        default:
+            return number * 86400;
+    }
+}
+
+
+/**
+ * @brief                                      Parses flags that has been arguments to the program. If -j
+ *                                             flag is set, an integer indicating the thread amount is also used.
+ *                                             If the -j flag is set to auto, the amount of threads is adjusted
+ *                                             while running.
+ *
+ * @param argc                                 Amount of parameters to the program.
+ * @param argv                                 Array of strings, containing the names of the arguments.
+ * @param options                              Pointer to the options of the scan, which the flags are stored in.
+ * @param report                               Pointer to the printing options, which the flags are stored in.
+ */
+void flag_options(int argc, char *argv[], Mdu_options *options, Report *report) {
+    static const struct option long_options[] = {
+        { "format",      required_argument, NULL, 'f' },
+        { "max-depth",   required_argument, NULL, 'd' },
+        { "all",         no_argument,       NULL, 'a' },
+        { "order",       required_argument, NULL, 'r' },
+        { "export",      required_argument, NULL, 'o' },
+        { "snapshot",    required_argument, NULL, 's' },
+        { "load",        required_argument, NULL, 'l' },
+        { "top",         required_argument, NULL, 't' },
+        { "diff",        required_argument, NULL, 'D' },
+        { "sort-inodes", no_argument,       NULL, 'i' },
+        { "deadline",    required_argument, NULL, 'T' },
+        { "estimate",    optional_argument, NULL, 'e' },
+        { "checkpoint",  required_argument, NULL, 'c' },
+        { "checkpoint-interval", required_argument, NULL, 'I' },
+        { "resume",      no_argument,       NULL, 'R' },
+        { "histogram",   no_argument,       NULL, 'h' },
+        { "by-owner",    optional_argument, NULL, 'O' },
+        { "by-type",     no_argument,       NULL, 'K' },
+        { "age",         required_argument, NULL, 'A' },
+        { "age-buckets", required_argument, NULL, 'B' },
+        { NULL,          0,                 NULL, 0   }
+    };
+    int option;
+    while ((option = getopt_long(argc, argv, "j:pLHd:ao:s:", long_options, NULL)) != -1) {
+        switch (option) {
+            case 'f':
+                if (strcmp(optarg, "ndjson") == 0) {
+                    report->format = FORMAT_NDJSON;
+                } else if (strcmp(optarg, "text") == 0) {
+                    report->format = FORMAT_TEXT;
+                } else {
+                    fprintf(stderr, "mdu: invalid format '%s', expected text or ndjson\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'd':
+                report->max_depth = atoi(optarg);
+                break;
+            case 'a':
+                report->all = true;
+                break;
+            case 'o':
+                report->export_path = optarg;
+                break;
+            case 's':
+                report->snapshot_path = optarg;
+                break;
+            case 'l':
+                report->load_path = optarg;
+                break;
+            case 't':
+                report->top = atol(optarg);
+                break;
+            case 'D':
+                report->diff_path = optarg;
+                break;
+            case 'r':
+                if (strcmp(optarg, "path") == 0) {
+                    report->sorted = true;
+                } else if (strcmp(optarg, "unordered") == 0) {
+                    report->sorted = false;
+                } else {
+                    fprintf(stderr, "mdu: invalid order '%s', expected unordered or path\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'p':
+                options->pin_threads = true;
+                break;
+            case 'L':
+                options->follow = MDU_FOLLOW_ALL;
+                break;
+            case 'H':
+                options->follow = MDU_FOLLOW_ROOTS;
+                break;
+            case 'i':
+                options->sort_inodes = true;
+                break;
+            case 'T':
+                options->deadline = atof(optarg);
+                break;
+            case 'e':
+                options->sample_rate = optarg != NULL ? atof(optarg) : ESTIMATE_DEFAULT_RATE;
+                if (options->sample_rate <= 0 || options->sample_rate > 1) {
+                    fprintf(stderr, "mdu: invalid estimate rate '%s', expected above 0 and at most 1\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'c':
+                options->checkpoint = optarg;
+                break;
+            case 'I':
+                options->checkpoint_interval = atof(optarg);
+                break;
+            case 'R':
+                options->resume = true;
+                break;
+            case 'h':
+                report->histogram = true;
+                break;
+            case 'O':
+                if (optarg == NULL || strcmp(optarg, "uid") == 0) {
+                    report->owner_key = MDU_OWNER_UID;
+                } else if (strcmp(optarg, "gid") == 0) {
+                    report->owner_key = MDU_OWNER_GID;
+                } else {
+                    fprintf(stderr, "mdu: invalid owner '%s', expected uid or gid\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'K':
+                report->by_type = true;
+                break;
+            case 'A':
+                if (strcmp(optarg, "mtime") == 0) {
+                    options->age = MDU_AGE_MTIME;
+                } else if (strcmp(optarg, "atime") == 0) {
+                    options->age = MDU_AGE_ATIME;
+                } else {
+                    fprintf(stderr, "mdu: invalid age '%s', expected mtime or atime\n", optarg);
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'B':
+                parse_age_boundaries(optarg, options, report);
+                break;
+            case 'j':
+                if (strcmp(optarg, "auto") == 0) {
+                    options->auto_threads = true;
+                } else {
+                    options->thread_amount = atoi(optarg);
+                }
+                break;
+            default:
+                break;
+        }
+    }
 }
 
 /**
@@ -0,0 +1,37 @@
+#!/bin/sh
+#
+# Compares the output of mdu -a --order=path with [du] -a. Both have to print the same sizes and paths, and mdu has
+# to print every directory after the paths inside of it, as du does. The siblings are in the order of readdir() in
+# du, so only the order of a directory and it's paths is compared.
+#
+
+mdu=${1:-./mdu}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir"' EXIT
+
+mkdir -p "$dir/a/b/c" "$dir/a-b" "$dir/ab" "$dir/a.b/d" "$dir/z"
+for path in a/x a/b/y a/b/c/w a-b/z ab/v a.b/d/u .h z/t; do
+    head -c 5000 /dev/zero > "$dir/$path"
+done
+
+status=0
+for threads in 1 4; do
+    "$mdu" -a --order=path -j "$threads" "$dir" > "$dir.mdu" || status=1
+    du -a -B 512 "$dir" > "$dir.du"
+
+    if [ "$(sort "$dir.mdu")" != "$(sort "$dir.du")" ]; then
+        echo "order_test: mdu -j $threads and du print different sizes or paths"
+        diff "$dir.mdu" "$dir.du"
+        status=1
+    fi
+    #a directory that has been printed can't have a path inside of it printed after it
+    if ! cut -f 2 "$dir.mdu" | awk '{ for (p in printed) if (index($0, p "/") == 1) bad = 1 }
+                                    { printed[$0] = 1 }
+                                    END { exit bad }'; then
+        echo "order_test: mdu -j $threads prints a directory before the paths inside of it"
+        status=1
+    fi
+done
+rm -f "$dir.mdu" "$dir.du"
+[ $status -eq 0 ] && echo "order_test: passed"
+exit $status
@@ -0,0 +1,453 @@
+/**
+ * @brief This datatype has operations for writing records to a file descriptor through one buffer per thread.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 2.0
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/uio.h>
+#include "output.h"
+
+static void reserve(Output *output, Output_buffer *buffer, size_t size);
+static Output_chunk *take_chunk(Output *output, size_t size);
+static void finish_chunk(Output *output, Output_buffer *buffer, Output_chunk *chunk);
+static void release_chunks(Output *output, Output_chunk *chunks);
+static void *run_writer(void *arg);
+static void write_chunks(int fd, Output_chunk *chunks);
+static void write_sorted(Output *output);
+static int compare_records(const void *a, const void *b);
+static void write_iovecs(int fd, struct iovec *iov, int iov_amount);
+
+Output *create_output(int fd, int buffer_amount, bool sorted) {
+    Output *output = malloc(sizeof(Output));
+    error_handler_null(output, NULL, "output couldn't allocate memory", true);
+    output->fd = fd;
+    output->sorted = sorted;
+    output->buffer_amount = buffer_amount;
+    output->buffers = malloc(buffer_amount * sizeof(Output_buffer *));
+    error_handler_null(output->buffers, NULL, "output buffers couldn't allocate memory", true);
+    for (int i = 0; i < buffer_amount; i++) {
+        output->buffers[i] = calloc(1, sizeof(Output_buffer));
+        error_handler_null(output->buffers[i], NULL, "output buffer couldn't allocate memory", true);
+    }
+    output->queue_head = NULL;
+    output->queue_tail = NULL;
+    output->queue_length = 0;
+    output->free_chunks = NULL;
+    output->free_amount = 0;
+    output->shutdown = false;
+    pthread_mutex_init(&output->mutex, NULL);
+    pthread_cond_init(&output->cond, NULL);
+    pthread_cond_init(&output->space_cond, NULL);
+
+    if (!sorted) {
+        int check = pthread_create(&output->writer, NULL, run_writer, output);
+        error_handler_value(0, -check, NULL, "writer thread couldn't be created", false);
+    }
+    return output;
+}
+
+void output_begin_record(Output *output, int buffer, const char *key) {
+    Output_buffer *out = output->buffers[buffer];
+    if (!output->sorted) {
+        return;
+    }
+    size_t key_length = strlen(key) + 1;
+    reserve(output, out, key_length);
+    memcpy(out->chunk->data + out->chunk->length, key, key_length);
+    out->chunk->length += key_length;
+}
+
+void output_printf(Output *output, int buffer, const char *format, ...) {
+    Output_buffer *out = output->buffers[buffer];
+    reserve(output, out, 1);
+    Output_chunk *chunk = out->chunk;
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(chunk->data + chunk->length, chunk->capacity - chunk->length, format, args);
+    va_end(args);
+    error_handler_value(0, length, NULL, "output couldn't format a record", false);
+
+    if ((size_t)length >= chunk->capacity - chunk->length) {
+        reserve(output, out, length + 1);
+        chunk = out->chunk;
+        va_start(args, format);
+        vsnprintf(chunk->data + chunk->length, chunk->capacity - chunk->length, format, args);
+        va_end(args);
+    }
+    chunk->length += length;
+}
+
+void output_json_string(Output *output, int buffer, const char *string) {
+    Output_buffer *out = output->buffers[buffer];
+    //an escaped byte is at most 6 bytes, and the quotes are two more
+    reserve(output, out, strlen(string) * 6 + 3);
+    out->chunk->length += json_escape(out->chunk->data + out->chunk->length, string);
+}
+
+size_t json_escape(char *dest, const char *string) {
+    char *data = dest;
+    *data++ = '"';
+    for (const unsigned char *c = (const unsigned char *)string; *c != '\0'; c++) {
+        switch (*c) {
+            case '"':  *data++ = '\\'; *data++ = '"';  break;
+            case '\\': *data++ = '\\'; *data++ = '\\'; break;
+            case '\n': *data++ = '\\'; *data++ = 'n';  break;
+            case '\r': *data++ = '\\'; *data++ = 'r';  break;
+            case '\t': *data++ = '\\'; *data++ = 't';  break;
+            default:
+                if (*c < 0x20 || *c == 0x7f) {
+                    data += sprintf(data, "\\u%04x", *c);
+                } else {
+                    *data++ = (char)*c;
+                }
+                break;
+        }
+    }
+    *data++ = '"';
+    *data = '\0';
+    return data - dest;
+}
+
+void output_end_record(Output *output, int buffer) {
+    Output_buffer *out = output->buffers[buffer];
+    if (out->chunk == NULL) {
+        return;
+    }
+    if (output->sorted) {
+        if (out->record_amount == out->record_capacity) {
+            out->record_capacity = out->record_capacity == 0 ? 1024 : out->record_capacity * 2;
+            out->records = realloc(out->records, out->record_capacity * sizeof(Output_record));
+            error_handler_null(out->records, NULL, "output records couldn't allocate memory", true);
+        }
+        Output_record *record = &out->records[out->record_amount++];
+        record->key = out->chunk->data + out->record_start;
+        record->text = record->key + strlen(record->key) + 1;
+        record->length = out->chunk->data + out->chunk->length - record->text;
+    }
+    out->record_start = out->chunk->length;
+}
+
+void output_flush_all(Output *output, int last) {
+    if (output->sorted) {
+        write_sorted(output);
+        return;
+    }
+    for (int i = 0; i <= output->buffer_amount; i++) {
+        //the last buffer is handed over after the others
+        if (i == last) {
+            continue;
+        }
+        Output_buffer *out = output->buffers[i < output->buffer_amount ? i : last];
+        if (out->chunk != NULL) {
+            finish_chunk(output, out, out->chunk);
+            out->chunk = NULL;
+            out->record_start = 0;
+        }
+    }
+}
+
+void destroy_output(Output *output) {
+    output_flush_all(output, 0);
+    if (!output->sorted) {
+        pthread_mutex_lock(&output->mutex);
+        output->shutdown = true;
+        pthread_cond_signal(&output->cond);
+        pthread_mutex_unlock(&output->mutex);
+        pthread_join(output->writer, NULL);
+    }
+    for (int i = 0; i < output->buffer_amount; i++) {
+        release_chunks(output, output->buffers[i]->chunk);
+        free(output->buffers[i]->records);
+        free(output->buffers[i]);
+    }
+    while (output->free_chunks != NULL) {
+        Output_chunk *chunk = output->free_chunks;
+        output->free_chunks = chunk->next;
+        free(chunk->data);
+        free(chunk);
+    }
+    free(output->buffers);
+    pthread_mutex_destroy(&output->mutex);
+    pthread_cond_destroy(&output->cond);
+    pthread_cond_destroy(&output->space_cond);
+    free(output);
+}
+
+/**
+ * @brief                Makes sure that the chunk of a buffer has room for more bytes.
+ *
+ *                       If it doesn't, the buffer gets a new chunk and the current record is moved into it,
+ *                       so that a record is never split. The old chunk is finished.
+ *
+ * @param output         The output.
+ * @param buffer         The buffer.
+ * @param size           Amount of bytes that has to fit after the bytes already in the chunk.
+ */
+static void reserve(Output *output, Output_buffer *buffer, size_t size) {
+    Output_chunk *chunk = buffer->chunk;
+    if (chunk != NULL && chunk->capacity - chunk->length >= size) {
+        return;
+    }
+    size_t partial = chunk == NULL ? 0 : chunk->length - buffer->record_start;
+    Output_chunk *new_chunk = take_chunk(output, partial + size);
+    if (chunk != NULL) {
+        memcpy(new_chunk->data, chunk->data + buffer->record_start, partial);
+        new_chunk->length = partial;
+        chunk->length = buffer->record_start;
+        finish_chunk(output, buffer, chunk);
+    }
+    buffer->chunk = new_chunk;
+    buffer->record_start = 0;
+}
+
+/**
+ * @brief                Gives an empty chunk, a written one if there is one that is large enough.
+ *
+ * @param output         The output.
+ * @param size           The least amount of bytes that the chunk has to fit.
+ * @return               Returns an empty chunk.
+ */
+static Output_chunk *take_chunk(Output *output, size_t size) {
+    Output_chunk *chunk = NULL;
+    pthread_mutex_lock(&output->mutex);
+    if (output->free_chunks != NULL && output->free_chunks->capacity >= size) {
+        chunk = output->free_chunks;
+        output->free_chunks = chunk->next;
+        output->free_amount--;
+    }
+    pthread_mutex_unlock(&output->mutex);
+
+    if (chunk == NULL) {
+        chunk = malloc(sizeof(Output_chunk));
+        error_handler_null(chunk, NULL, "output chunk couldn't allocate memory", true);
+        chunk->capacity = size > OUTPUT_CHUNK_SIZE ? size : OUTPUT_CHUNK_SIZE;
+        chunk->data = malloc(chunk->capacity);
+        error_handler_null(chunk->data, NULL, "output chunk couldn't allocate memory", true);
+    }
+    chunk->length = 0;
+    chunk->next = NULL;
+    return chunk;
+}
+
+/**
+ * @brief                Finishes a chunk that no more records will be added to.
+ *
+ *                       Sorted, the chunk is kept by the buffer until it's records are written. Unordered,
+ *                       the chunk is added to the queue of the writer. If the queue is full, the calling
+ *                       thread waits until the writer has taken the queue.
+ *
+ * @param output         The output.
+ * @param buffer         The buffer that the chunk belongs to.
+ * @param chunk          The chunk.
+ */
+static void finish_chunk(Output *output, Output_buffer *buffer, Output_chunk *chunk) {
+    if (chunk->length == 0) {
+        chunk->next = NULL;
+        release_chunks(output, chunk);
+    } else if (output->sorted) {
+        chunk->next = buffer->kept;
+        buffer->kept = chunk;
+    } else {
+        pthread_mutex_lock(&output->mutex);
+        while (output->queue_length >= OUTPUT_QUEUE_MAX) {
+            pthread_cond_wait(&output->space_cond, &output->mutex);
+        }
+        chunk->next = NULL;
+        if (output->queue_tail == NULL) {
+            output->queue_head = chunk;
+        } else {
+            output->queue_tail->next = chunk;
+        }
+        output->queue_tail = chunk;
+        output->queue_length++;
+        pthread_cond_signal(&output->cond);
+        pthread_mutex_unlock(&output->mutex);
+    }
+}
+
+/**
+ * @brief                Gives a list of written chunks back to the output, so they can be used again. Chunks
+ *                       past OUTPUT_FREE_MAX, or larger than OUTPUT_CHUNK_SIZE, are deallocated.
+ *
+ * @param output         The output.
+ * @param chunks         The first chunk in the list, NULL for no chunks.
+ */
+static void release_chunks(Output *output, Output_chunk *chunks) {
+    while (chunks != NULL) {
+        Output_chunk *chunk = chunks;
+        chunks = chunk->next;
+        pthread_mutex_lock(&output->mutex);
+        if (output->free_amount < OUTPUT_FREE_MAX && chunk->capacity == OUTPUT_CHUNK_SIZE) {
+            chunk->next = output->free_chunks;
+            output->free_chunks = chunk;
+            output->free_amount++;
+            chunk = NULL;
+        }
+        pthread_mutex_unlock(&output->mutex);
+        if (chunk != NULL) {
+            free(chunk->data);
+            free(chunk);
+        }
+    }
+}
+
+/**
+ * @brief                The function of the writer thread. Takes every chunk in the queue at once, and writes
+ *                       them, until the output is shut down and the queue is empty.
+ *
+ * @param arg            A pointer to the output.
+ * @return               Returns NULL.
+ */
+static void *run_writer(void *arg) {
+    Output *output = arg;
+    pthread_mutex_lock(&output->mutex);
+    while (true) {
+        while (output->queue_head == NULL && !output->shutdown) {
+            pthread_cond_wait(&output->cond, &output->mutex);
+        }
+        if (output->queue_head == NULL) {
+            break;
+        }
+        Output_chunk *chunks = output->queue_head;
+        output->queue_head = NULL;
+        output->queue_tail = NULL;
+        output->queue_length = 0;
+        pthread_cond_broadcast(&output->space_cond);
+        pthread_mutex_unlock(&output->mutex);
+
+        write_chunks(output->fd, chunks);
+        release_chunks(output, chunks);
+        pthread_mutex_lock(&output->mutex);
+    }
+    pthread_mutex_unlock(&output->mutex);
+    return NULL;
+}
+
+/**
+ * @brief                Writes a list of chunks, in order, with writev().
+ *
+ * @param fd             The file descriptor.
+ * @param chunks         The first chunk in the list.
+ */
+static void write_chunks(int fd, Output_chunk *chunks) {
+    struct iovec iov[OUTPUT_QUEUE_MAX];
+    int iov_amount = 0;
+    for (Output_chunk *chunk = chunks; chunk != NULL; chunk = chunk->next) {
+        iov[iov_amount].iov_base = chunk->data;
+        iov[iov_amount].iov_len = chunk->length;
+        iov_amount++;
+        if (iov_amount == OUTPUT_QUEUE_MAX) {
+            write_iovecs(fd, iov, iov_amount);
+            iov_amount = 0;
+        }
+    }
+    write_iovecs(fd, iov, iov_amount);
+}
+
+/**
+ * @brief                Sorts the kept records of every buffer by their keys, writes them with writev(), and
+ *                       gives their chunks back to the output.
+ *
+ * @param output         The output.
+ */
+static void write_sorted(Output *output) {
+    size_t record_amount = 0;
+    for (int i = 0; i < output->buffer_amount; i++) {
+        record_amount += output->buffers[i]->record_amount;
+    }
+    Output_record *records = malloc((record_amount + 1) * sizeof(Output_record));
+    error_handler_null(records, NULL, "output records couldn't allocate memory", true);
+    size_t index = 0;
+    for (int i = 0; i < output->buffer_amount; i++) {
+        Output_buffer *out = output->buffers[i];
+        if (out->record_amount > 0) {
+            memcpy(&records[index], out->records, out->record_amount * sizeof(Output_record));
+            index += out->record_amount;
+        }
+    }
+    qsort(records, record_amount, sizeof(Output_record), compare_records);
+
+    struct iovec iov[OUTPUT_IOV_MAX];
+    int iov_amount = 0;
+    for (size_t i = 0; i < record_amount; i++) {
+        iov[iov_amount].iov_base = (void *)records[i].text;
+        iov[iov_amount].iov_len = records[i].length;
+        iov_amount++;
+        if (iov_amount == OUTPUT_IOV_MAX) {
+            write_iovecs(output->fd, iov, iov_amount);
+            iov_amount = 0;
+        }
+    }
+    write_iovecs(output->fd, iov, iov_amount);
+    free(records);
+
+    for (int i = 0; i < output->buffer_amount; i++) {
+        Output_buffer *out = output->buffers[i];
+        release_chunks(output, out->kept);
+        out->kept = NULL;
+        out->record_amount = 0;
+        if (out->chunk != NULL) {
+            out->chunk->length = 0;
+            out->record_start = 0;
+        }
+    }
+}
+
+/**
+ * @brief                Compares two records by their keys, as paths. A '/' comes before the end of a key,
+ *                       which comes before every other byte, so a directory comes right after the paths inside
+ *                       of it, as in [du]. A key that ends with '/' comes after the keys that it's a prefix of.
+ *
+ * @param a              A pointer to the first record.
+ * @param b              A pointer to the second record.
+ * @return               Returns less than, equal to, or greater than 0, if a comes before, is equal to, or
+ *                       comes after b.
+ */
+static int compare_records(const void *a, const void *b) {
+    const unsigned char *key_a = (const unsigned char *)((const Output_record *)a)->key;
+    const unsigned char *key_b = (const unsigned char *)((const Output_record *)b)->key;
+    const unsigned char *start = key_a;
+    while (*key_a != '\0' && *key_a == *key_b) {
+        key_a++;
+        key_b++;
+    }
+    //a root such as "/" or "dir/" is a prefix of it's paths, up to and with the '/'
+    if (key_a != start && key_a[-1] == '/' && (*key_a == '\0') != (*key_b == '\0')) {
+        return *key_a == '\0' ? 1 : -1;
+    }
+    int rank_a = *key_a == '/' ? 0 : *key_a == '\0' ? 1 : *key_a + 1;
+    int rank_b = *key_b == '/' ? 0 : *key_b == '\0' ? 1 : *key_b + 1;
+    return rank_a - rank_b;
+}
+
+/**
+ * @brief                Writes an array of iovecs, until every byte has been written.
+ *
+ * @param fd             The file descriptor.
+ * @param iov            The iovecs. They are changed when only a part of them could be written.
+ * @param iov_amount     Amount of iovecs.
+ */
+static void write_iovecs(int fd, struct iovec *iov, int iov_amount) {
+    while (iov_amount > 0) {
+        ssize_t written = writev(fd, iov, iov_amount);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        error_handler_value(0, written < 0 ? -1 : 0, NULL, "output couldn't be written", true);
+        while (iov_amount > 0 && (size_t)written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            iov_amount--;
+        }
+        if (iov_amount > 0) {
+            iov->iov_base = (char *)iov->iov_base + written;
+            iov->iov_len -= written;
+        }
+    }
+}
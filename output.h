@@ -0,0 +1,215 @@
+/**
+ * @defgroup output_h output
+ *
+ * @brief This datatype has operations for writing records to a file descriptor through one buffer per thread.
+ *
+ * Every thread formats it's records into chunks of it's own buffer, so the threads doesn't wait on each other
+ * while formatting. A record is never split between two chunks.
+ *
+ * Unordered, a full chunk is handed to a writer thread, which writes every chunk that is waiting with one
+ * writev(). The threads only waits on the writer if OUTPUT_QUEUE_MAX chunks are waiting to be written.
+ *
+ * Sorted, the chunks are kept together with an index of the records, until output_flush_all sorts the records
+ * by their keys and writes them with writev().
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 2.0
+ *
+ * @{
+ */
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "error_handler.h"
+
+#define OUTPUT_CHUNK_SIZE 65536
+#define OUTPUT_QUEUE_MAX 64
+#define OUTPUT_FREE_MAX 64
+#define OUTPUT_IOV_MAX 1024 //IOV_MAX on Linux, the most iovecs that one writev() takes
+
+/**
+ * @brief                  A struct which is the structure for a chunk of formatted records.
+ *
+ * @elem data              The formatted records.
+ * @elem length            Amount of bytes in data.
+ * @elem capacity          Amount of bytes that has been allocated for data.
+ * @elem next              The next chunk in the queue of the writer, or in a list of chunks.
+ */
+typedef struct output_chunk {
+    char *data;
+    size_t length;
+    size_t capacity;
+    struct output_chunk *next;
+} Output_chunk;
+
+/**
+ * @brief                  A struct which is the structure for a record that is kept to be sorted.
+ *
+ * @elem key               The key that the record is sorted by, stored in the chunk before the text.
+ * @elem text              The formatted record.
+ * @elem length            Amount of bytes in text.
+ */
+typedef struct output_record {
+    const char *key;
+    const char *text;
+    size_t length;
+} Output_record;
+
+/**
+ * @brief                  A struct which is the structure for the buffer of one thread.
+ *
+ * @elem chunk             The chunk that records are formatted into. NULL until the first record.
+ * @elem record_start      The offset in the chunk where the current record starts.
+ * @elem kept              The full chunks that are kept until they are sorted.
+ * @elem records           An array with the index of the records that are kept.
+ * @elem record_amount     Amount of records that are kept.
+ * @elem record_capacity   Amount of records that has been allocated for.
+ */
+typedef struct output_buffer {
+    Output_chunk *chunk;
+    size_t record_start;
+    Output_chunk *kept;
+    Output_record *records;
+    size_t record_amount;
+    size_t record_capacity;
+} Output_buffer;
+
+/**
+ * @brief                  A struct which is the structure for an output.
+ *
+ * @elem fd                The file descriptor that the records are written to.
+ * @elem sorted            True if the records are sorted by their keys before they are written.
+ * @elem buffers           An array of pointers to the buffers, one for each thread. Every buffer is allocated
+ *                         on it's own, so two threads never write to the same cache line.
+ * @elem buffer_amount     Amount of buffers.
+ * @elem queue_head        The first chunk that is waiting for the writer.
+ * @elem queue_tail        The last chunk that is waiting for the writer.
+ * @elem queue_length      Amount of chunks that are waiting for the writer.
+ * @elem free_chunks       Written chunks that can be used again.
+ * @elem free_amount       Amount of chunks in free_chunks.
+ * @elem mutex             A variable for holding a mutex lock, for the queue and the free chunks.
+ * @elem cond              A condition variable for waking the writer.
+ * @elem space_cond        A condition variable for waking threads that waits for room in the queue.
+ * @elem shutdown          True when the writer should exit, once the queue is empty.
+ * @elem writer            The writer thread. Only started if the output is unordered.
+ */
+typedef struct output {
+    int fd;
+    bool sorted;
+    Output_buffer **buffers;
+    int buffer_amount;
+    Output_chunk *queue_head;
+    Output_chunk *queue_tail;
+    int queue_length;
+    Output_chunk *free_chunks;
+    int free_amount;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    pthread_cond_t space_cond;
+    bool shutdown;
+    pthread_t writer;
+} Output;
+
+
+/**
+ * @brief                Creates an output, and allocates memory for it. An unordered output starts it's
+ *                       writer thread.
+ *
+ * @param fd             The file descriptor that the records will be written to.
+ * @param buffer_amount  Amount of buffers, one for each thread that writes records.
+ * @param sorted         True if the records should be sorted by their keys, false if they should be
+ *                       written as soon as possible.
+ * @return               Returns an output that has been dynamically allocated.
+ */
+Output *create_output(int fd, int buffer_amount, bool sorted);
+
+
+/**
+ * @brief                Starts a record in a buffer.
+ *
+ * @param output         The output.
+ * @param buffer         The index of the buffer, the id of the calling thread.
+ * @param key            The key that the record is sorted by. Only used if the output is sorted.
+ */
+void output_begin_record(Output *output, int buffer, const char *key);
+
+
+/**
+ * @brief                Formats text into the current record of a buffer, in the same way as printf.
+ *
+ * @param output         The output.
+ * @param buffer         The index of the buffer, the id of the calling thread.
+ * @param format         The format string.
+ */
+void output_printf(Output *output, int buffer, const char *format, ...) __attribute__((format(printf, 3, 4)));
+
+
+/**
+ * @brief                Adds a string to the current record of a buffer as a quoted JSON string.
+ *
+ *                       Quotes, backslashes and control characters are escaped. Other bytes are added as
+ *                       they are, since a path doesn't have to be valid UTF-8.
+ *
+ * @param output         The output.
+ * @param buffer         The index of the buffer, the id of the calling thread.
+ * @param string         The string.
+ */
+void output_json_string(Output *output, int buffer, const char *string);
+
+
+/**
+ * @brief                Writes a string as a quoted JSON string, in the same way as output_json_string.
+ *
+ * @param dest           Where the JSON string is written. Must have room for 6 bytes for every byte of the
+ *                       string, and 3 more.
+ * @param string         The string.
+ * @return               Amount of bytes written to dest, without a null terminator.
+ */
+size_t json_escape(char *dest, const char *string);
+
+
+/**
+ * @brief                Ends the current record of a buffer.
+ *
+ * @param output         The output.
+ * @param buffer         The index of the buffer, the id of the calling thread.
+ */
+void output_end_record(Output *output, int buffer);
+
+
+/**
+ * @brief                Writes the records of every buffer.
+ *
+ *                       Unordered, the chunks are handed to the writer. Sorted, the records of every buffer
+ *                       are sorted together and written before returning.
+ *
+ *                       The threads that owns the buffers must not be writing records while this is called.
+ *
+ * @param output         The output.
+ * @param last           The index of the buffer that is handed to the writer after the others, so that it's
+ *                       records comes last. Only used if the output is unordered.
+ */
+void output_flush_all(Output *output, int last);
+
+
+/**
+ * @brief                Writes the records of every buffer, waits for the writer to finish, and deallocates
+ *                       the output.
+ *
+ * @param output         The output that will be deallocated.
+ */
+void destroy_output(Output *output);
+
+#endif //OUTPUT_H
+
+/**
+ * @}
+ */
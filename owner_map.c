@@ -0,0 +1,145 @@
+/**
+ * @brief This datatype is a map from the ids of owners, users or groups, to the amount of files and blocks that
+ * they own.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 1.0
+ *
+ */
+
+#include <string.h>
+#include "owner_map.h"
+
+static uint64_t hash_owner(id_t id);
+static Mdu_owner *find_owner(Owner_map *map, id_t id);
+static void grow_map(Owner_map *map);
+static int compare_owners(const void *owner, const void *other);
+
+Owner_map *create_owner_map(void) {
+    Owner_map *map = malloc(sizeof(Owner_map));
+    error_handler_null(map, NULL, "owner map couldn't allocate memory", true);
+    map->slots = NULL;
+    map->amount = 0;
+    map->capacity = 0;
+    return map;
+}
+
+void owner_map_add(Owner_map *map, id_t id, long file_amount, blkcnt_t block_size) {
+    Mdu_owner *owner = find_owner(map, id);
+    owner->file_amount += file_amount;
+    owner->block_size += block_size;
+}
+
+void owner_map_merge(Owner_map *map, const Owner_map *other) {
+    for (size_t i = 0; i < other->capacity; i++) {
+        if (other->slots[i].used) {
+            owner_map_add(map, other->slots[i].owner.id, other->slots[i].owner.file_amount,
+                          other->slots[i].owner.block_size);
+        }
+    }
+}
+
+Mdu_owner *owner_map_sorted(const Owner_map *map) {
+    if (map->amount == 0) {
+        return NULL;
+    }
+    Mdu_owner *owners = malloc(map->amount * sizeof(Mdu_owner));
+    error_handler_null(owners, NULL, "owner map couldn't allocate memory", true);
+    size_t amount = 0;
+    for (size_t i = 0; i < map->capacity; i++) {
+        if (map->slots[i].used) {
+            owners[amount++] = map->slots[i].owner;
+        }
+    }
+    qsort(owners, amount, sizeof(Mdu_owner), compare_owners);
+    return owners;
+}
+
+void owner_map_clear(Owner_map *map) {
+    if (map->slots != NULL) {
+        memset(map->slots, 0, map->capacity * sizeof(Owner_slot));
+    }
+    map->amount = 0;
+}
+
+void destroy_owner_map(Owner_map *map) {
+    free(map->slots);
+    free(map);
+}
+
+/**
+ * @brief                Hashes the id of an owner, with the finalizer of splitmix64.
+ *
+ * @param id             The id.
+ * @return               The hash.
+ */
+static uint64_t hash_owner(id_t id) {
+    uint64_t x = (uint64_t)id * 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief                Finds an owner in the map, and adds it without files or blocks if it isn't in it.
+ *
+ * @param map            The map.
+ * @param id             The id of the owner.
+ * @return               The owner in the map.
+ */
+static Mdu_owner *find_owner(Owner_map *map, id_t id) {
+    if (2 * (map->amount + 1) > map->capacity) {
+        grow_map(map);
+    }
+    size_t mask = map->capacity - 1;
+    size_t slot = hash_owner(id) & mask;
+    while (map->slots[slot].used) {
+        if (map->slots[slot].owner.id == id) {
+            return &map->slots[slot].owner;
+        }
+        slot = (slot + 1) & mask;
+    }
+    map->slots[slot] = (Owner_slot) { .owner = { .id = id, .file_amount = 0, .block_size = 0 }, .used = true };
+    map->amount++;
+    return &map->slots[slot].owner;
+}
+
+/**
+ * @brief                Doubles the hash table of the map, and places every owner again.
+ *
+ * @param map            The map.
+ */
+static void grow_map(Owner_map *map) {
+    size_t capacity = map->capacity == 0 ? OWNER_MAP_START_CAPACITY : map->capacity * 2;
+    Owner_slot *slots = calloc(capacity, sizeof(Owner_slot));
+    error_handler_null(slots, NULL, "owner map couldn't allocate memory", true);
+    for (size_t i = 0; i < map->capacity; i++) {
+        if (map->slots[i].used) {
+            size_t slot = hash_owner(map->slots[i].owner.id) & (capacity - 1);
+            while (slots[slot].used) {
+                slot = (slot + 1) & (capacity - 1);
+            }
+            slots[slot] = map->slots[i];
+        }
+    }
+    free(map->slots);
+    map->slots = slots;
+    map->capacity = capacity;
+}
+
+/**
+ * @brief                Compares two owners for qsort, by their blocks with the most first, and by their ids.
+ *
+ * @param owner          The first owner.
+ * @param other          The second owner.
+ * @return               Negative if owner comes first, positive if other does.
+ */
+static int compare_owners(const void *owner, const void *other) {
+    const Mdu_owner *a = owner;
+    const Mdu_owner *b = other;
+    if (a->block_size != b->block_size) {
+        return a->block_size > b->block_size ? -1 : 1;
+    }
+    return (a->id > b->id) - (a->id < b->id);
+}
@@ -0,0 +1,112 @@
+/**
+ * @defgroup owner_map_h owner_map
+ *
+ * @brief This datatype is a map from the ids of owners, users or groups, to the amount of files and blocks that
+ * they own.
+ *
+ * A map is only used by one thread, so it isn't locked. It's a hash table with open addressing, which is
+ * doubled when it's half full. The maps of several threads are added together with owner_map_merge.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 1.0
+ *
+ * @{
+ */
+
+#ifndef OWNER_MAP_H
+#define OWNER_MAP_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "libmdu.h"
+#include "error_handler.h"
+
+#define OWNER_MAP_START_CAPACITY 16
+
+/**
+ * @brief                  A struct which is the structure for a slot of the map.
+ *
+ * @elem owner             The owner, with it's files and blocks.
+ * @elem used              True if the slot holds an owner.
+ */
+typedef struct owner_slot {
+    Mdu_owner owner;
+    bool used;
+} Owner_slot;
+
+/**
+ * @brief                  A struct which is the structure for the map.
+ *
+ * @elem slots             The hash table, NULL until the first owner is added.
+ * @elem amount            Amount of owners in the map.
+ * @elem capacity          Amount of slots in the hash table, a power of 2.
+ */
+typedef struct owner_map {
+    Owner_slot *slots;
+    size_t amount;
+    size_t capacity;
+} Owner_map;
+
+
+/**
+ * @brief                Creates an empty map, and allocates memory for it.
+ *
+ * @return               Returns a map that has been dynamically allocated.
+ */
+Owner_map *create_owner_map(void);
+
+
+/**
+ * @brief                Adds files and blocks to an owner, which is added to the map if it isn't in it.
+ *
+ * @param map            The map.
+ * @param id             The user or group id of the owner.
+ * @param file_amount    Amount of files that are added.
+ * @param block_size     Amount of blocks that are added.
+ */
+void owner_map_add(Owner_map *map, id_t id, long file_amount, blkcnt_t block_size);
+
+
+/**
+ * @brief                Adds every owner of a map to another map.
+ *
+ * @param map            The map that is added to.
+ * @param other          The map that is added.
+ */
+void owner_map_merge(Owner_map *map, const Owner_map *other);
+
+
+/**
+ * @brief                Copies the owners of the map to an array, with the owner of the most blocks first.
+ *
+ * @param map            The map.
+ * @return               Returns an array of map->amount owners that has been dynamically allocated. NULL if the
+ *                       map is empty.
+ */
+Mdu_owner *owner_map_sorted(const Owner_map *map);
+
+
+/**
+ * @brief                Removes every owner from the map.
+ *
+ * @param map            The map.
+ */
+void owner_map_clear(Owner_map *map);
+
+
+/**
+ * @brief                Deallocates the map.
+ *
+ * @param map            The map that will be deallocated.
+ */
+void destroy_owner_map(Owner_map *map);
+
+#endif //OWNER_MAP_H
+
+/**
+ * @}
+ */
@@ -0,0 +1,753 @@
+/**
+ * @brief This datatype writes the directories of a scan to a binary snapshot, and loads snapshots for queries.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 1.0
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "snapshot.h"
+
+#define REF_SPOOL_SHIFT 40
+
+/**
+ * @brief                  A struct which is the structure for a record in the order it is written.
+ *
+ * @elem ref               The reference to the record in the spool files.
+ * @elem parent            The parent of the record, as in Snapshot_record.
+ */
+typedef struct snapshot_order {
+    uint64_t ref;
+    uint64_t parent;
+} Snapshot_order;
+
+static uint64_t make_ref(int spool, uint64_t index);
+static const Snapshot_spool_record *ref_record(const Snapshot_writer *writer, uint64_t ref);
+static const char *ref_name(const Snapshot_writer *writer, uint64_t ref);
+static void *map_spool(FILE *file, size_t size);
+static int compare_refs(const void *a, const void *b, void *arg);
+static int compare_names(const char *name, size_t length, const char *other, size_t other_length);
+static void write_snapshot(Snapshot_writer *writer);
+static uint64_t find_child(const Snapshot *snapshot, uint64_t index, const char *name, size_t length,
+                           bool *found);
+static void sift_down(const Snapshot_record *records, uint64_t *heap, uint64_t length);
+static void add_delta(Snapshot_delta *heap, uint64_t *length, uint64_t amount, Snapshot_delta delta);
+static void sift_delta(Snapshot_delta *heap, uint64_t length);
+static int64_t magnitude(int64_t delta);
+static void push_join(Snapshot_join **stack, uint64_t *length, uint64_t *capacity, const Snapshot *old,
+                      int64_t old_index, const Snapshot *new, int64_t new_index);
+static int64_t find_root(const Snapshot *snapshot, const Snapshot *other, uint64_t index);
+static size_t root_length(const Snapshot *snapshot, uint64_t index);
+static bool needs_separator(const Snapshot *snapshot, uint64_t parent);
+static bool check_records(const Snapshot *snapshot);
+
+Snapshot_writer *create_snapshot_writer(FILE *file, int spool_amount) {
+    Snapshot_writer *writer = malloc(sizeof(Snapshot_writer));
+    error_handler_null(writer, NULL, "snapshot writer couldn't allocate memory", true);
+    writer->file = file;
+    writer->spool_amount = spool_amount;
+    writer->spools = malloc(spool_amount * sizeof(Snapshot_spool *));
+    error_handler_null(writer->spools, NULL, "snapshot spools couldn't allocate memory", true);
+    for (int i = 0; i < spool_amount; i++) {
+        Snapshot_spool *spool = calloc(1, sizeof(Snapshot_spool));
+        error_handler_null(spool, NULL, "snapshot spool couldn't allocate memory", true);
+        spool->records = tmpfile();
+        error_handler_null(spool->records, NULL, "snapshot spool file couldn't be created", true);
+        spool->names = tmpfile();
+        error_handler_null(spool->names, NULL, "snapshot spool file couldn't be created", true);
+        writer->spools[i] = spool;
+    }
+    writer->root_amount = 0;
+    writer->root_capacity = 16;
+    writer->roots = malloc(writer->root_capacity * sizeof(uint64_t));
+    error_handler_null(writer->roots, NULL, "snapshot roots couldn't allocate memory", true);
+    return writer;
+}
+
+void snapshot_add_dir(Snapshot_writer *writer, const Mdu_entry *entry) {
+    Snapshot_spool *spool = writer->spools[entry->worker];
+    const char *name = entry->depth == 0 ? entry->path : strrchr(entry->path, '/') + 1;
+    Snapshot_spool_record record = { .id = entry->id, .parent_id = entry->parent_id,
+                                     .name_offset = spool->names_length, .name_length = strlen(name),
+                                     .depth = entry->depth, .totals = entry->totals };
+    fwrite(name, 1, record.name_length + 1, spool->names);
+    spool->names_length += record.name_length + 1;
+    fwrite(&record, sizeof(record), 1, spool->records);
+
+    //roots are completed one at a time, after everything inside of them
+    if (entry->depth == 0) {
+        if (writer->root_amount == writer->root_capacity) {
+            writer->root_capacity *= 2;
+            writer->roots = realloc(writer->roots, writer->root_capacity * sizeof(uint64_t));
+            error_handler_null(writer->roots, NULL, "snapshot roots couldn't allocate memory", true);
+        }
+        writer->roots[writer->root_amount++] = make_ref(entry->worker, spool->record_amount);
+    }
+    spool->record_amount++;
+}
+
+void destroy_snapshot_writer(Snapshot_writer *writer) {
+    write_snapshot(writer);
+    for (int i = 0; i < writer->spool_amount; i++) {
+        Snapshot_spool *spool = writer->spools[i];
+        if (spool->record_map != NULL) {
+            munmap((void *)spool->record_map, spool->record_amount * sizeof(Snapshot_spool_record));
+        }
+        if (spool->name_map != NULL) {
+            munmap((void *)spool->name_map, spool->names_length);
+        }
+        fclose(spool->records);
+        fclose(spool->names);
+        free(spool);
+    }
+    free(writer->spools);
+    free(writer->roots);
+    free(writer);
+}
+
+Snapshot *load_snapshot(const char *path) {
+    int fd = open(path, O_RDONLY);
+    error_handler_value(0, fd, NULL, (char *)path, true);
+    return load_snapshot_fd(fd, path);
+}
+
+Snapshot *load_snapshot_fd(int fd, const char *path) {
+    Snapshot *snapshot = malloc(sizeof(Snapshot));
+    error_handler_null(snapshot, NULL, "snapshot couldn't allocate memory", true);
+    struct stat buf;
+    error_handler_value(0, fstat(fd, &buf), NULL, (char *)path, true);
+    snapshot->size = buf.st_size;
+    if (snapshot->size < sizeof(Snapshot_header)) {
+        fprintf(stderr, "mdu: '%s' isn't a snapshot\n", path);
+        exit(EXIT_FAILURE);
+    }
+    snapshot->map = mmap(NULL, snapshot->size, PROT_READ, MAP_SHARED, fd, 0);
+    error_handler_null(snapshot->map == MAP_FAILED ? NULL : snapshot->map, NULL, (char *)path, true);
+    close(fd);
+
+    const Snapshot_header *header = snapshot->map;
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || header->version != SNAPSHOT_VERSION
+        || header->byte_order != SNAPSHOT_BYTE_ORDER
+        || header->record_amount > (snapshot->size - sizeof(Snapshot_header)) / sizeof(Snapshot_record)
+        || header->names_offset != sizeof(Snapshot_header) + header->record_amount * sizeof(Snapshot_record)
+        || header->names_length > snapshot->size - header->names_offset) {
+        fprintf(stderr, "mdu: '%s' isn't a snapshot that can be read\n", path);
+        exit(EXIT_FAILURE);
+    }
+    snapshot->header = header;
+    snapshot->records = (const Snapshot_record *)(header + 1);
+    snapshot->names = (const char *)snapshot->map + header->names_offset;
+    if (!check_records(snapshot)) {
+        fprintf(stderr, "mdu: '%s' is a corrupt snapshot\n", path);
+        exit(EXIT_FAILURE);
+    }
+    return snapshot;
+}
+
+int64_t snapshot_find(const Snapshot *snapshot, const char *path) {
+    size_t path_length = strlen(path);
+    while (path_length > 1 && path[path_length - 1] == '/') {
+        path_length--;
+    }
+
+    //the longest root that the path starts with
+    int64_t index = -1;
+    size_t matched = 0;
+    for (uint64_t i = 0; i < snapshot->header->root_amount; i++) {
+        const Snapshot_record *root = &snapshot->records[i];
+        const char *name = snapshot->names + root->name_offset;
+        size_t length = root->name_length;
+        while (length > 1 && name[length - 1] == '/') {
+            length--;
+        }
+        if (length <= path_length && memcmp(name, path, length) == 0 && length >= matched
+            && (length == path_length || path[length] == '/' || name[length - 1] == '/')) {
+            index = i;
+            matched = length;
+        }
+    }
+
+    const char *component = path + matched;
+    while (index >= 0 && component < path + path_length) {
+        while (*component == '/') {
+            component++;
+        }
+        size_t length = strcspn(component, "/");
+        if (component + length > path + path_length) {
+            length = path + path_length - component;
+        }
+        if (length == 0) {
+            break;
+        }
+        bool found;
+        uint64_t child = find_child(snapshot, index, component, length, &found);
+        index = found ? (int64_t)child : -1;
+        component += length;
+    }
+    return index;
+}
+
+uint64_t snapshot_children(const Snapshot *snapshot, uint64_t index, uint64_t *first) {
+    //the records are sorted by parent, so the children are found with two binary searches
+    uint64_t parent = index + 1;
+    uint64_t low = snapshot->header->root_amount;
+    uint64_t high = snapshot->header->record_amount;
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        if (snapshot->records[middle].parent < parent) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    *first = low;
+    high = snapshot->header->record_amount;
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        if (snapshot->records[middle].parent <= parent) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low - *first;
+}
+
+char *snapshot_path(const Snapshot *snapshot, uint64_t index) {
+    size_t length = 0;
+    for (uint64_t i = index + 1; i != SNAPSHOT_NO_PARENT; i = snapshot->records[i - 1].parent) {
+        length += snapshot->records[i - 1].name_length + needs_separator(snapshot, snapshot->records[i - 1].parent);
+    }
+    char *path = malloc(length + 1);
+    error_handler_null(path, NULL, "snapshot path couldn't allocate memory", true);
+
+    //the path is built from the end
+    path[length] = '\0';
+    for (uint64_t i = index + 1; i != SNAPSHOT_NO_PARENT; i = snapshot->records[i - 1].parent) {
+        const Snapshot_record *record = &snapshot->records[i - 1];
+        length -= record->name_length;
+        memcpy(path + length, snapshot->names + record->name_offset, record->name_length);
+        if (needs_separator(snapshot, record->parent)) {
+            path[--length] = '/';
+        }
+    }
+    return path;
+}
+
+uint64_t *snapshot_top(const Snapshot *snapshot, uint64_t amount, uint64_t *found) {
+    uint64_t record_amount = snapshot->header->record_amount;
+    if (amount > record_amount) {
+        amount = record_amount;
+    }
+    uint64_t *heap = malloc((amount + 1) * sizeof(uint64_t));
+    error_handler_null(heap, NULL, "snapshot top couldn't allocate memory", true);
+    const Snapshot_record *records = snapshot->records;
+
+    //a min-heap of the largest directories so far, the smallest of them on top
+    uint64_t length = 0;
+    for (uint64_t i = 0; i < record_amount && amount > 0; i++) {
+        if (length < amount) {
+            uint64_t child = length++;
+            heap[child] = i;
+            while (child > 0 && records[heap[(child - 1) / 2]].block_size > records[heap[child]].block_size) {
+                uint64_t temp = heap[child];
+                heap[child] = heap[(child - 1) / 2];
+                heap[(child - 1) / 2] = temp;
+                child = (child - 1) / 2;
+            }
+        } else if (records[i].block_size > records[heap[0]].block_size) {
+            heap[0] = i;
+            sift_down(records, heap, length);
+        }
+    }
+
+    //removing the smallest one at a time, to the end of the heap, leaves the largest first
+    *found = length;
+    while (length > 1) {
+        uint64_t smallest = heap[0];
+        heap[0] = heap[--length];
+        sift_down(records, heap, length);
+        heap[length] = smallest;
+    }
+    return heap;
+}
+
+Snapshot_delta *snapshot_diff(const Snapshot *old, const Snapshot *new, uint64_t amount, uint64_t *found) {
+    Snapshot_delta *heap = malloc((amount + 1) * sizeof(Snapshot_delta));
+    error_handler_null(heap, NULL, "snapshot diff couldn't allocate memory", true);
+    uint64_t length = 0;
+    uint64_t stack_length = 0;
+    uint64_t stack_capacity = 64;
+    Snapshot_join *stack = malloc(stack_capacity * sizeof(Snapshot_join));
+    error_handler_null(stack, NULL, "snapshot diff couldn't allocate memory", true);
+
+    //the roots are in the order they were scanned, so they are matched by their paths
+    uint64_t root_amount = old->header->root_amount + new->header->root_amount;
+    for (uint64_t i = 0; i < root_amount; i++) {
+        int64_t old_index = -1;
+        int64_t new_index = -1;
+        if (i < old->header->root_amount) {
+            old_index = i;
+            new_index = find_root(new, old, i);
+        } else if (find_root(old, new, i - old->header->root_amount) < 0) {
+            new_index = i - old->header->root_amount;
+        } else {
+            continue;
+        }
+
+        int64_t old_size = old_index >= 0 ? old->records[old_index].block_size : 0;
+        int64_t new_size = new_index >= 0 ? new->records[new_index].block_size : 0;
+        add_delta(heap, &length, amount, (Snapshot_delta) { old_index, new_index, new_size - old_size });
+        push_join(&stack, &stack_length, &stack_capacity, old, old_index, new, new_index);
+
+        //every step takes the next child from one or both lists, and goes down into it
+        while (stack_length > 0) {
+            Snapshot_join *join = &stack[stack_length - 1];
+            bool old_left = join->old_next < join->old_end;
+            bool new_left = join->new_next < join->new_end;
+            if (!old_left && !new_left) {
+                stack_length--;
+                continue;
+            }
+            int compared = !old_left ? 1 : !new_left ? -1 :
+                           compare_names(old->names + old->records[join->old_next].name_offset,
+                                         old->records[join->old_next].name_length,
+                                         new->names + new->records[join->new_next].name_offset,
+                                         new->records[join->new_next].name_length);
+            int64_t old_child = compared <= 0 ? (int64_t)join->old_next++ : -1;
+            int64_t new_child = compared >= 0 ? (int64_t)join->new_next++ : -1;
+            old_size = old_child >= 0 ? old->records[old_child].block_size : 0;
+            new_size = new_child >= 0 ? new->records[new_child].block_size : 0;
+            add_delta(heap, &length, amount, (Snapshot_delta) { old_child, new_child, new_size - old_size });
+            push_join(&stack, &stack_length, &stack_capacity, old, old_child, new, new_child);
+        }
+    }
+    free(stack);
+
+    //removing the smallest one at a time, to the end of the heap, leaves the largest first
+    *found = length;
+    while (length > 1) {
+        Snapshot_delta smallest = heap[0];
+        heap[0] = heap[--length];
+        sift_delta(heap, length);
+        heap[length] = smallest;
+    }
+    return heap;
+}
+
+void unload_snapshot(Snapshot *snapshot) {
+    munmap(snapshot->map, snapshot->size);
+    free(snapshot);
+}
+
+/**
+ * @brief                Makes a reference to a record in the spool files.
+ *
+ * @param spool          The index of the spool file.
+ * @param index          The index of the record in the spool file.
+ * @return               The reference.
+ */
+static uint64_t make_ref(int spool, uint64_t index) {
+    return ((uint64_t)spool << REF_SPOOL_SHIFT) | index;
+}
+
+/**
+ * @brief                Gives the record of a reference, from the mapped spool files.
+ *
+ * @param writer         The snapshot writer.
+ * @param ref            The reference.
+ * @return               The record.
+ */
+static const Snapshot_spool_record *ref_record(const Snapshot_writer *writer, uint64_t ref) {
+    const Snapshot_spool *spool = writer->spools[ref >> REF_SPOOL_SHIFT];
+    return &spool->record_map[ref & (((uint64_t)1 << REF_SPOOL_SHIFT) - 1)];
+}
+
+/**
+ * @brief                Gives the name of a reference, from the mapped spool files.
+ *
+ * @param writer         The snapshot writer.
+ * @param ref            The reference.
+ * @return               The name, null terminated.
+ */
+static const char *ref_name(const Snapshot_writer *writer, uint64_t ref) {
+    return writer->spools[ref >> REF_SPOOL_SHIFT]->name_map + ref_record(writer, ref)->name_offset;
+}
+
+/**
+ * @brief                Maps a spool file into memory.
+ *
+ * @param file           The spool file, which is flushed first.
+ * @param size           Amount of bytes in the spool file.
+ * @return               The mapped spool file. NULL if it's empty.
+ */
+static void *map_spool(FILE *file, size_t size) {
+    error_handler_value(0, fflush(file), NULL, "snapshot spool couldn't be written", true);
+    if (size == 0) {
+        return NULL;
+    }
+    void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    error_handler_null(map == MAP_FAILED ? NULL : map, NULL, "snapshot spool couldn't be mapped", true);
+    madvise(map, size, MADV_RANDOM);
+    return map;
+}
+
+/**
+ * @brief                Compares two references by the id of their parents, and then by their names.
+ *
+ * @param a              A pointer to the first reference.
+ * @param b              A pointer to the second reference.
+ * @param arg            A pointer to the snapshot writer.
+ * @return               Returns less than, equal to, or greater than 0, if a comes before, is equal to, or
+ *                       comes after b.
+ */
+static int compare_refs(const void *a, const void *b, void *arg) {
+    const Snapshot_writer *writer = arg;
+    uint64_t ref_a = *(const uint64_t *)a;
+    uint64_t ref_b = *(const uint64_t *)b;
+    const Snapshot_spool_record *record_a = ref_record(writer, ref_a);
+    const Snapshot_spool_record *record_b = ref_record(writer, ref_b);
+    if (record_a->parent_id != record_b->parent_id) {
+        return record_a->parent_id < record_b->parent_id ? -1 : 1;
+    }
+    return compare_names(ref_name(writer, ref_a), record_a->name_length,
+                         ref_name(writer, ref_b), record_b->name_length);
+}
+
+/**
+ * @brief                Compares two names byte by byte, a shorter name before a longer one that starts with it.
+ *
+ * @param name           The first name.
+ * @param length         Amount of bytes in the first name.
+ * @param other          The second name.
+ * @param other_length   Amount of bytes in the second name.
+ * @return               Returns less than, equal to, or greater than 0, if name comes before, is equal to, or
+ *                       comes after other.
+ */
+static int compare_names(const char *name, size_t length, const char *other, size_t other_length) {
+    int compared = memcmp(name, other, length < other_length ? length : other_length);
+    if (compared != 0) {
+        return compared;
+    }
+    return (length > other_length) - (length < other_length);
+}
+
+/**
+ * @brief                Writes the snapshot from the spool files.
+ *
+ *                       The references to every record that isn't a root are sorted by their parent and name,
+ *                       so the children of a directory are found with a binary search. The roots are then
+ *                       written, followed by the children of every written directory, which is a breadth first
+ *                       order where every record comes after it's parent.
+ *
+ * @param writer         The snapshot writer.
+ */
+static void write_snapshot(Snapshot_writer *writer) {
+    uint64_t record_amount = 0;
+    for (int i = 0; i < writer->spool_amount; i++) {
+        Snapshot_spool *spool = writer->spools[i];
+        spool->record_map = map_spool(spool->records, spool->record_amount * sizeof(Snapshot_spool_record));
+        spool->name_map = map_spool(spool->names, spool->names_length);
+        record_amount += spool->record_amount;
+    }
+
+    uint64_t child_amount = record_amount - writer->root_amount;
+    uint64_t *children = malloc((child_amount + 1) * sizeof(uint64_t));
+    error_handler_null(children, NULL, "snapshot children couldn't allocate memory", true);
+    uint64_t index = 0;
+    for (int i = 0; i < writer->spool_amount; i++) {
+        for (uint64_t j = 0; j < writer->spools[i]->record_amount; j++) {
+            if (writer->spools[i]->record_map[j].depth > 0) {
+                children[index++] = make_ref(i, j);
+            }
+        }
+    }
+    qsort_r(children, child_amount, sizeof(uint64_t), compare_refs, writer);
+
+    Snapshot_order *order = malloc((record_amount + 1) * sizeof(Snapshot_order));
+    error_handler_null(order, NULL, "snapshot order couldn't allocate memory", true);
+    uint64_t length = 0;
+    for (uint64_t i = 0; i < writer->root_amount; i++) {
+        order[length++] = (Snapshot_order) { .ref = writer->roots[i], .parent = SNAPSHOT_NO_PARENT };
+    }
+    for (uint64_t i = 0; i < length; i++) {
+        long id = ref_record(writer, order[i].ref)->id;
+        uint64_t low = 0;
+        uint64_t high = child_amount;
+        while (low < high) {
+            uint64_t middle = low + (high - low) / 2;
+            if (ref_record(writer, children[middle])->parent_id < id) {
+                low = middle + 1;
+            } else {
+                high = middle;
+            }
+        }
+        for (; low < child_amount && ref_record(writer, children[low])->parent_id == id; low++) {
+            order[length++] = (Snapshot_order) { .ref = children[low], .parent = i + 1 };
+        }
+    }
+    free(children);
+
+    Snapshot_header header = { .magic = SNAPSHOT_MAGIC, .version = SNAPSHOT_VERSION,
+                               .byte_order = SNAPSHOT_BYTE_ORDER, .record_amount = length,
+                               .root_amount = writer->root_amount,
+                               .names_offset = sizeof(Snapshot_header) + length * sizeof(Snapshot_record),
+                               .names_length = 0, .timestamp = time(NULL), .reserved = 0 };
+    for (uint64_t i = 0; i < length; i++) {
+        header.names_length += ref_record(writer, order[i].ref)->name_length + 1;
+    }
+    fwrite(&header, sizeof(header), 1, writer->file);
+
+    uint64_t name_offset = 0;
+    for (uint64_t i = 0; i < length; i++) {
+        const Snapshot_spool_record *spooled = ref_record(writer, order[i].ref);
+        Snapshot_record record = { .parent = order[i].parent, .name_offset = name_offset,
+                                   .name_length = spooled->name_length, .depth = spooled->depth,
+                                   .block_size = spooled->totals.block_size, .bytes = spooled->totals.bytes,
+                                   .file_amount = spooled->totals.file_amount,
+                                   .dir_amount = spooled->totals.dir_amount,
+                                   .error_amount = spooled->totals.error_amount };
+        fwrite(&record, sizeof(record), 1, writer->file);
+        name_offset += record.name_length + 1;
+    }
+    for (uint64_t i = 0; i < length; i++) {
+        fwrite(ref_name(writer, order[i].ref), 1, ref_record(writer, order[i].ref)->name_length + 1, writer->file);
+    }
+    free(order);
+    error_handler_value(0, fflush(writer->file), NULL, "snapshot couldn't be written", true);
+    error_handler_value(0, -ferror(writer->file), NULL, "snapshot couldn't be written", false);
+}
+
+/**
+ * @brief                Finds a directory by name, among the directories directly inside of a directory.
+ *
+ * @param snapshot       The snapshot.
+ * @param index          The index of the directory's record.
+ * @param name           The name, not null terminated.
+ * @param length         Amount of bytes in the name.
+ * @param found          Where true is stored if the directory was found.
+ * @return               The index of the record of the directory.
+ */
+static uint64_t find_child(const Snapshot *snapshot, uint64_t index, const char *name, size_t length,
+                           bool *found) {
+    uint64_t first;
+    uint64_t low = 0;
+    uint64_t high = snapshot_children(snapshot, index, &first);
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        const Snapshot_record *record = &snapshot->records[first + middle];
+        int compared = compare_names(snapshot->names + record->name_offset, record->name_length, name, length);
+        if (compared == 0) {
+            *found = true;
+            return first + middle;
+        }
+        if (compared < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    *found = false;
+    return 0;
+}
+
+/**
+ * @brief                Moves the top of a min-heap down, until it's children are larger.
+ *
+ * @param records        The records that the heap holds indexes of.
+ * @param heap           The heap.
+ * @param length         Amount of indexes in the heap.
+ */
+static void sift_down(const Snapshot_record *records, uint64_t *heap, uint64_t length) {
+    for (uint64_t parent = 0, child; (child = parent * 2 + 1) < length; parent = child) {
+        if (child + 1 < length && records[heap[child + 1]].block_size < records[heap[child]].block_size) {
+            child++;
+        }
+        if (records[heap[parent]].block_size <= records[heap[child]].block_size) {
+            break;
+        }
+        uint64_t temp = heap[parent];
+        heap[parent] = heap[child];
+        heap[child] = temp;
+    }
+}
+
+/**
+ * @brief                Checks if a '/' goes between the path of a directory and the name of a child.
+ *
+ * @param snapshot       The snapshot.
+ * @param parent         The directory, as in the parent of Snapshot_record.
+ * @return               False for no directory, or if the directory's name already ends with a '/'.
+ */
+static bool needs_separator(const Snapshot *snapshot, uint64_t parent) {
+    if (parent == SNAPSHOT_NO_PARENT) {
+        return false;
+    }
+    const Snapshot_record *record = &snapshot->records[parent - 1];
+    return record->name_length == 0 || snapshot->names[record->name_offset + record->name_length - 1] != '/';
+}
+
+/**
+ * @brief                Adds a difference to a min-heap of the largest changes, if it's larger than the smallest
+ *                       of them. Directories that didn't change are left out.
+ *
+ * @param heap           The heap, with room for amount differences.
+ * @param length         Amount of differences in the heap.
+ * @param amount         The most differences that the heap keeps.
+ * @param delta          The difference.
+ */
+static void add_delta(Snapshot_delta *heap, uint64_t *length, uint64_t amount, Snapshot_delta delta) {
+    if (delta.delta == 0 || amount == 0) {
+        return;
+    }
+    if (*length < amount) {
+        uint64_t child = (*length)++;
+        heap[child] = delta;
+        while (child > 0 && magnitude(heap[(child - 1) / 2].delta) > magnitude(heap[child].delta)) {
+            Snapshot_delta temp = heap[child];
+            heap[child] = heap[(child - 1) / 2];
+            heap[(child - 1) / 2] = temp;
+            child = (child - 1) / 2;
+        }
+    } else if (magnitude(delta.delta) > magnitude(heap[0].delta)) {
+        heap[0] = delta;
+        sift_delta(heap, *length);
+    }
+}
+
+/**
+ * @brief                Moves the top of a min-heap of differences down, until it's children are larger.
+ *
+ * @param heap           The heap.
+ * @param length         Amount of differences in the heap.
+ */
+static void sift_delta(Snapshot_delta *heap, uint64_t length) {
+    for (uint64_t parent = 0, child; (child = parent * 2 + 1) < length; parent = child) {
+        if (child + 1 < length && magnitude(heap[child + 1].delta) < magnitude(heap[child].delta)) {
+            child++;
+        }
+        if (magnitude(heap[parent].delta) <= magnitude(heap[child].delta)) {
+            break;
+        }
+        Snapshot_delta temp = heap[parent];
+        heap[parent] = heap[child];
+        heap[child] = temp;
+    }
+}
+
+/**
+ * @brief                Gives the size of a change, whether it grew or shrunk.
+ *
+ * @param delta          The change.
+ * @return               The absolute value of delta.
+ */
+static int64_t magnitude(int64_t delta) {
+    return delta < 0 ? -delta : delta;
+}
+
+/**
+ * @brief                Pushes the children of two matching directories onto the stack of a diff.
+ *
+ * @param stack          The stack, which grows when it's full.
+ * @param length         Amount of joins on the stack.
+ * @param capacity       Amount of joins that has been allocated for.
+ * @param old            The old snapshot.
+ * @param old_index      The index of the directory in the old snapshot, -1 if it isn't there.
+ * @param new            The new snapshot.
+ * @param new_index      The index of the directory in the new snapshot, -1 if it isn't there.
+ */
+static void push_join(Snapshot_join **stack, uint64_t *length, uint64_t *capacity, const Snapshot *old,
+                      int64_t old_index, const Snapshot *new, int64_t new_index) {
+    if (*length == *capacity) {
+        *capacity *= 2;
+        *stack = realloc(*stack, *capacity * sizeof(Snapshot_join));
+        error_handler_null(*stack, NULL, "snapshot diff couldn't allocate memory", true);
+    }
+    Snapshot_join *join = &(*stack)[(*length)++];
+    join->old_next = join->old_end = join->new_next = join->new_end = 0;
+    if (old_index >= 0) {
+        join->old_end = snapshot_children(old, old_index, &join->old_next);
+        join->old_end += join->old_next;
+    }
+    if (new_index >= 0) {
+        join->new_end = snapshot_children(new, new_index, &join->new_next);
+        join->new_end += join->new_next;
+    }
+}
+
+/**
+ * @brief                Finds the root of a snapshot that has the same path as a root of another snapshot.
+ *
+ * @param snapshot       The snapshot that is searched.
+ * @param other          The other snapshot.
+ * @param index          The index of the root in the other snapshot.
+ * @return               The index of the root. -1 if there is no root with the path.
+ */
+static int64_t find_root(const Snapshot *snapshot, const Snapshot *other, uint64_t index) {
+    const char *name = other->names + other->records[index].name_offset;
+    size_t length = root_length(other, index);
+    for (uint64_t i = 0; i < snapshot->header->root_amount; i++) {
+        if (root_length(snapshot, i) == length
+            && memcmp(snapshot->names + snapshot->records[i].name_offset, name, length) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief                Gives the length of the name of a root, without any trailing '/'.
+ *
+ * @param snapshot       The snapshot.
+ * @param index          The index of the root.
+ * @return               The length.
+ */
+static size_t root_length(const Snapshot *snapshot, uint64_t index) {
+    const char *name = snapshot->names + snapshot->records[index].name_offset;
+    size_t length = snapshot->records[index].name_length;
+    while (length > 1 && name[length - 1] == '/') {
+        length--;
+    }
+    return length;
+}
+
+/**
+ * @brief                Checks that every record of a loaded snapshot can be followed without reading outside of
+ *                       the mapping. The roots have no parent, every other record has a parent before it, the
+ *                       records are sorted by parent, and every name is inside of the string table and null
+ *                       terminated.
+ *
+ * @param snapshot       The snapshot, with a header that has been checked.
+ * @return               True if every record is valid.
+ */
+static bool check_records(const Snapshot *snapshot) {
+    const Snapshot_header *header = snapshot->header;
+    if (header->root_amount > header->record_amount) {
+        return false;
+    }
+    for (uint64_t i = 0; i < header->record_amount; i++) {
+        const Snapshot_record *record = &snapshot->records[i];
+        if (i < header->root_amount ? record->parent != SNAPSHOT_NO_PARENT
+                                    : record->parent == SNAPSHOT_NO_PARENT || record->parent - 1 >= i) {
+            return false;
+        }
+        if (i > header->root_amount && record->parent < snapshot->records[i - 1].parent) {
+            return false;
+        }
+        if (record->name_offset >= header->names_length
+            || record->name_length >= header->names_length - record->name_offset
+            || snapshot->names[record->name_offset + record->name_length] != '\0') {
+            return false;
+        }
+    }
+    return true;
+}
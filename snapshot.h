@@ -0,0 +1,315 @@
+/**
+ * @defgroup snapshot_h snapshot
+ *
+ * @brief This datatype writes the directories of a scan to a binary snapshot, and loads snapshots for queries.
+ *
+ * A snapshot has a header, one fixed-width record for every directory, and a string table with the names of
+ * the directories. The roots come first, and then the directories in breadth first order, so the records are
+ * sorted by their parent and the directories inside of one directory are next to each other, sorted by name.
+ * A path is found by binary searching for the children of one directory at a time.
+ *
+ * While scanning, every thread streams it's records and names to spool files. When the snapshot is written,
+ * only the order of the records is kept in memory, the records themselves are read from the mapped spool files.
+ * A snapshot is loaded with mmap, and used where it is without parsing. The numbers are in the byte order of the
+ * machine that wrote it.
+ *
+ * Two snapshots are compared by walking both trees at the same time. The children of two matching directories
+ * are both sorted by name, so they are merge-joined in one pass, and only the directories on the way down from
+ * the roots are kept on a stack.
+ *
+ * @author  Ludwig Fallström
+ * @since   2026-10-16
+ * @version 1.1
+ *
+ * @{
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "libmdu.h"
+#include "error_handler.h"
+
+#define SNAPSHOT_MAGIC "MDUSNAP"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_BYTE_ORDER 0x01020304
+#define SNAPSHOT_NO_PARENT 0
+
+/**
+ * @brief                  A struct which is the structure for the header of a snapshot.
+ *
+ * @elem magic             SNAPSHOT_MAGIC, null terminated.
+ * @elem version           SNAPSHOT_VERSION.
+ * @elem byte_order        SNAPSHOT_BYTE_ORDER, as written by the machine that wrote the snapshot.
+ * @elem record_amount     Amount of records.
+ * @elem root_amount       Amount of roots, the first records.
+ * @elem names_offset      The offset in the file where the string table starts.
+ * @elem names_length      Amount of bytes in the string table.
+ * @elem timestamp         When the snapshot was written, in seconds since the epoch.
+ * @elem reserved          Always 0.
+ */
+typedef struct snapshot_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t record_amount;
+    uint64_t root_amount;
+    uint64_t names_offset;
+    uint64_t names_length;
+    int64_t timestamp;
+    uint64_t reserved;
+} Snapshot_header;
+
+/**
+ * @brief                  A struct which is the structure for the record of a directory in a snapshot.
+ *
+ * @elem parent            The index of the parent's record plus one. SNAPSHOT_NO_PARENT for a root.
+ * @elem name_offset       The offset of the name in the string table. The name is null terminated.
+ * @elem name_length       Amount of bytes in the name. The whole path for a root, the last component for
+ *                         the other directories.
+ * @elem depth             How many directories below the root the directory is.
+ * @elem block_size        The totals of the file tree of the directory, as in Mdu_totals.
+ * @elem bytes             See block_size.
+ * @elem file_amount       See block_size.
+ * @elem dir_amount        See block_size.
+ * @elem error_amount      See block_size.
+ */
+typedef struct snapshot_record {
+    uint64_t parent;
+    uint64_t name_offset;
+    uint32_t name_length;
+    int32_t depth;
+    int64_t block_size;
+    int64_t bytes;
+    int64_t file_amount;
+    int64_t dir_amount;
+    int64_t error_amount;
+} Snapshot_record;
+
+/**
+ * @brief                  A struct which is the structure for a record in a spool file.
+ *
+ * @elem id                The id of the directory, from the entries of the scan.
+ * @elem parent_id         The id of the parent, 0 for a root.
+ * @elem name_offset       The offset of the name in the name spool file of the same thread.
+ * @elem name_length       Amount of bytes in the name.
+ * @elem depth             How many directories below the root the directory is.
+ * @elem totals            The totals of the file tree of the directory.
+ */
+typedef struct snapshot_spool_record {
+    long id;
+    long parent_id;
+    uint64_t name_offset;
+    uint32_t name_length;
+    int32_t depth;
+    Mdu_totals totals;
+} Snapshot_spool_record;
+
+/**
+ * @brief                  A struct which is the structure for the spool files of one thread.
+ *
+ * @elem records           The spool file for the records.
+ * @elem names             The spool file for the names.
+ * @elem record_amount     Amount of records in the spool file.
+ * @elem names_length      Amount of bytes in the name spool file.
+ * @elem record_map        The mapped record spool file, while the snapshot is written.
+ * @elem name_map          The mapped name spool file, while the snapshot is written.
+ */
+typedef struct snapshot_spool {
+    FILE *records;
+    FILE *names;
+    uint64_t record_amount;
+    uint64_t names_length;
+    const Snapshot_spool_record *record_map;
+    const char *name_map;
+} Snapshot_spool;
+
+/**
+ * @brief                  A struct which is the structure for the difference of one directory between two
+ *                         snapshots.
+ *
+ * @elem old_index         The index of the directory's record in the old snapshot. -1 if it's only in the new.
+ * @elem new_index         The index of the directory's record in the new snapshot. -1 if it's only in the old.
+ * @elem delta             The size in the new snapshot minus the size in the old, in blocks.
+ */
+typedef struct snapshot_delta {
+    int64_t old_index;
+    int64_t new_index;
+    int64_t delta;
+} Snapshot_delta;
+
+/**
+ * @brief                  A struct which is the structure for two lists of children that are merge-joined.
+ *
+ * @elem old_next          The index of the next child in the old snapshot.
+ * @elem old_end           The index after the last child in the old snapshot.
+ * @elem new_next          The index of the next child in the new snapshot.
+ * @elem new_end           The index after the last child in the new snapshot.
+ */
+typedef struct snapshot_join {
+    uint64_t old_next;
+    uint64_t old_end;
+    uint64_t new_next;
+    uint64_t new_end;
+} Snapshot_join;
+
+/**
+ * @brief                  A struct which is the structure for a snapshot that is being written.
+ *
+ * @elem file              The file that the snapshot is written to.
+ * @elem spools            An array of pointers to the spool files, one for each thread.
+ * @elem spool_amount      Amount of spool files.
+ * @elem roots             References to the records of the roots, in the order they were completed.
+ * @elem root_amount       Amount of roots.
+ * @elem root_capacity     Amount of roots that has been allocated for.
+ */
+typedef struct snapshot_writer {
+    FILE *file;
+    Snapshot_spool **spools;
+    int spool_amount;
+    uint64_t *roots;
+    uint64_t root_amount;
+    uint64_t root_capacity;
+} Snapshot_writer;
+
+/**
+ * @brief                  A struct which is the structure for a loaded snapshot.
+ *
+ * @elem map               The mapped snapshot file.
+ * @elem size              Amount of bytes in map.
+ * @elem header            The header of the snapshot.
+ * @elem records           The records of the snapshot.
+ * @elem names             The string table of the snapshot.
+ */
+typedef struct snapshot {
+    void *map;
+    size_t size;
+    const Snapshot_header *header;
+    const Snapshot_record *records;
+    const char *names;
+} Snapshot;
+
+
+/**
+ * @brief                Creates a snapshot writer, and allocates memory for it.
+ *
+ * @param file           The file that the snapshot will be written to.
+ * @param spool_amount   Amount of spool files, one for each thread that gives entries.
+ * @return               Returns a snapshot writer that has been dynamically allocated.
+ */
+Snapshot_writer *create_snapshot_writer(FILE *file, int spool_amount);
+
+
+/**
+ * @brief                Adds a completed directory, or a root, to the spool files of the thread that completed
+ *                       it.
+ *
+ * @param writer         The snapshot writer.
+ * @param entry          The directory.
+ */
+void snapshot_add_dir(Snapshot_writer *writer, const Mdu_entry *entry);
+
+
+/**
+ * @brief                Writes the snapshot to the file, and deallocates the writer and it's spool files.
+ *
+ * @param writer         The snapshot writer that will be deallocated.
+ */
+void destroy_snapshot_writer(Snapshot_writer *writer);
+
+
+/**
+ * @brief                Loads a snapshot by mapping it into memory. Exits the program if the file isn't a
+ *                       snapshot that can be read by this machine.
+ *
+ * @param path           The path of the snapshot file.
+ * @return               Returns a snapshot that has been dynamically allocated.
+ */
+Snapshot *load_snapshot(const char *path);
+
+
+/**
+ * @brief                Loads a snapshot from an open file, in the same way as load_snapshot.
+ *
+ * @param fd             The file descriptor of the snapshot file, which is closed.
+ * @param path           The path of the snapshot file, for the error messages.
+ * @return               Returns a snapshot that has been dynamically allocated.
+ */
+Snapshot *load_snapshot_fd(int fd, const char *path);
+
+
+/**
+ * @brief                Finds the record of a directory by it's path. The path starts with the path of one of
+ *                       the roots.
+ *
+ * @param snapshot       The snapshot.
+ * @param path           The path of the directory.
+ * @return               The index of the record. -1 if the directory isn't in the snapshot.
+ */
+int64_t snapshot_find(const Snapshot *snapshot, const char *path);
+
+
+/**
+ * @brief                Finds the records of the directories directly inside of a directory.
+ *
+ * @param snapshot       The snapshot.
+ * @param index          The index of the directory's record.
+ * @param first          Where the index of the first child is stored.
+ * @return               Amount of children. They are the records from first, sorted by name.
+ */
+uint64_t snapshot_children(const Snapshot *snapshot, uint64_t index, uint64_t *first);
+
+
+/**
+ * @brief                Gives the whole path of a record.
+ *
+ * @param snapshot       The snapshot.
+ * @param index          The index of the record.
+ * @return               The path, dynamically allocated.
+ */
+char *snapshot_path(const Snapshot *snapshot, uint64_t index);
+
+
+/**
+ * @brief                Finds the largest directories, by their size in blocks.
+ *
+ * @param snapshot       The snapshot.
+ * @param amount         The most directories to find.
+ * @param found          Where the amount of directories that was found is stored.
+ * @return               The indexes of the records, the largest first, dynamically allocated.
+ */
+uint64_t *snapshot_top(const Snapshot *snapshot, uint64_t amount, uint64_t *found);
+
+
+/**
+ * @brief                Finds the directories whose size changed the most between two snapshots, grown or
+ *                       shrunk. A directory that is only in one of the snapshots has the size 0 in the other.
+ *                       Roots are matched by their paths.
+ *
+ * @param old            The old snapshot.
+ * @param new            The new snapshot.
+ * @param amount         The most directories to find.
+ * @param found          Where the amount of directories that was found is stored.
+ * @return               The differences, the largest change first, dynamically allocated.
+ */
+Snapshot_delta *snapshot_diff(const Snapshot *old, const Snapshot *new, uint64_t amount, uint64_t *found);
+
+
+/**
+ * @brief                Unmaps a snapshot and deallocates it.
+ *
+ * @param snapshot       The snapshot that will be deallocated.
+ */
+void unload_snapshot(Snapshot *snapshot);
+
+#endif //SNAPSHOT_H
+
+/**
+ * @}
+ */
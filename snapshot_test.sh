@@ -0,0 +1,42 @@
+#!/bin/sh
+#
+# Saves a snapshot of a tree with mdu -s, changes the tree, and reads the snapshot back with --load. The loaded
+# sizes have to be the ones that [du] gave before the change, and not the ones of the changed tree.
+#
+
+mdu=${1:-./mdu}
+dir=$(mktemp -d)
+trap 'rm -rf "$dir" "$dir.snap" "$dir.mdu" "$dir.du"' EXIT
+
+mkdir -p "$dir/a/b" "$dir/c" "$dir/d"
+for path in a/x a/b/y c/z d/w; do
+    head -c 9000 /dev/zero > "$dir/$path"
+done
+
+status=0
+"$mdu" -s "$dir.snap" -j 4 "$dir" > /dev/null || status=1
+du -B 512 "$dir" > "$dir.du"
+rm -r "$dir/a/b"
+head -c 50000 /dev/zero > "$dir/c/v"
+
+"$mdu" --load="$dir.snap" -d 10 "$dir" > "$dir.mdu" || status=1
+if [ "$(sort "$dir.mdu")" != "$(sort "$dir.du")" ]; then
+    echo "snapshot_test: --load prints other sizes than du gave before the tree was changed"
+    diff "$dir.mdu" "$dir.du"
+    status=1
+fi
+if [ "$(sort "$dir.mdu")" = "$(du -B 512 "$dir" | sort)" ]; then
+    echo "snapshot_test: --load prints the sizes of the changed tree"
+    status=1
+fi
+#without paths, only the roots of the snapshot are printed
+if [ "$("$mdu" --load="$dir.snap")" != "$(tail -n 1 "$dir.du")" ]; then
+    echo "snapshot_test: --load without paths doesn't print the root as du did"
+    status=1
+fi
+if "$mdu" --load="$dir.snap" "$dir/a/nothing" > /dev/null 2>&1; then
+    echo "snapshot_test: --load of a path that isn't in the snapshot succeeds"
+    status=1
+fi
+[ $status -eq 0 ] && echo "snapshot_test: passed"
+exit $status
@@ -12,25 +12,61 @@
 
 #include "t_queue.h"
 
-Task_queue *create_task_queue(int thread_amount) {
+Task_queue *create_task_queue(int thread_amount, bool auto_threads) {
     Task_queue *q = malloc(sizeof(Task_queue));
     error_handler_null(q, NULL, "queue couldn't allocate memory", true);
     q->task_q = list_create();
     q->thread_amount = thread_amount;
-    q->block_size = 0;
+    q->workers = malloc(thread_amount * sizeof(Worker *));
+    error_handler_null(q->workers, NULL, "workers couldn't allocate memory", true);
+    for (int i = 0; i < thread_amount; i++) {
+        q->workers[i] = create_worker(q, i);
+    }
+    set_steal_order(q);
+    q->auto_threads = auto_threads;
+    q->follow = MDU_FOLLOW_NONE;
+    q->visited = NULL;
+    q->shared_roots = NULL;
+    q->shared_amount = 0;
+    q->sort_inodes = false;
+    q->sample_rate = 1;
+    q->age = MDU_AGE_NONE;
+    q->age_boundary_amount = 0;
+    q->owner_key = MDU_OWNER_NONE;
+    q->has_deadline = false;
+    q->cancel = NULL;
+    q->checkpoint = NULL;
+    q->pausing = false;
+    q->thread_limit = auto_threads ? AUTO_THREAD_START : thread_amount;
+    q->queue_length = 0;
+    q->entries = 0;
+    q->carried_fds = 0;
+    q->carried_fd_max = 0;
+    q->totals = (Mdu_totals) { 0 };
+    q->duration = 0;
+    q->dir_callback = NULL;
+    q->file_callback = NULL;
+    q->callback_data = NULL;
     q->t_running = 0;
+    q->tasks_done = 0;
+    q->fd_waiting = 0;
     q->shutdown = false;
     q->permission = true;
     pthread_mutex_init(&q->mutex, NULL);
     pthread_cond_init(&q->cond, NULL);
+    pthread_cond_init(&q->park_cond, NULL);
+    pthread_cond_init(&q->fd_cond, NULL);
     return q;
 }
 
-Task *create_task(char *path, void (*task_pointer)(struct task *, Task_queue *)) {
+Task *create_task(Dir_node *node, void (*task_pointer)(struct task *, Worker *)) {
     Task *task = malloc(sizeof(Task));
     error_handler_null(task, NULL, "task couldn't allocate memory", true);
-    task->path = path;
-    task->task_pointer = (blkcnt_t (*)(struct task *, Task_queue *)) (void (*)(void)) task_pointer;
+    task->node = node;
+    task->entries = 0;
+    task->inline_depth = 0;
+    task->carried_fd = false;
+    task->task_pointer = (blkcnt_t (*)(struct task *, Worker *)) (void (*)(void)) task_pointer;
     return task;
 }
 
@@ -39,6 +75,7 @@ void enqueue(Task_queue *queue, Task *task) {
     List *list = queue->task_q;
     ListPos first_pos = list_prev(list_first(list));
     list_insert(first_pos, task);
+    __atomic_add_fetch(&queue->queue_length, 1, __ATOMIC_SEQ_CST);
 }
 
 
@@ -57,6 +94,7 @@ Task *dequeue(Task_queue *queue) {
         *copy_task = *task;
         //frees the old task
         list_remove(task_pos);
+        __atomic_sub_fetch(&queue->queue_length, 1, __ATOMIC_SEQ_CST);
     }
     return copy_task;
 }
@@ -65,21 +103,133 @@ bool queue_is_empty(Task_queue *queue) {
     return list_is_empty(queue->task_q);
 }
 
+long waiting_tasks(Task_queue *queue) {
+    return __atomic_load_n(&queue->queue_length, __ATOMIC_SEQ_CST);
+}
+
 void destroy_queue(Task_queue *queue) {
     while (!queue_is_empty(queue)) {
         kill_task(dequeue(queue));
     }
+    for (int i = 0; i < queue->thread_amount; i++) {
+        destroy_worker(queue->workers[i]);
+    }
+    free(queue->workers);
+    if (queue->visited != NULL) {
+        destroy_inode_set(queue->visited);
+    }
+    free(queue->shared_roots);
     pthread_mutex_destroy(&queue->mutex);
     pthread_cond_destroy(&queue->cond);
+    pthread_cond_destroy(&queue->park_cond);
+    pthread_cond_destroy(&queue->fd_cond);
     free(queue->task_q);
     free(queue);
 }
 
+Worker *create_worker(Task_queue *t_queue, int id) {
+    Worker *worker = malloc(sizeof(Worker));
+    error_handler_null(worker, NULL, "worker couldn't allocate memory", true);
+    worker->deque = list_create();
+    worker->id = id;
+    worker->cpu = -1;
+    worker->node = 0;
+    worker->dir_amount = 0;
+    worker->random_state = 0x9E3779B97F4A7C15ULL * (unsigned long long)(id + 1);
+    worker->histogram = NULL;
+    worker->owners = NULL;
+    worker->extensions = NULL;
+    worker->steal_order = malloc(t_queue->thread_amount * sizeof(int));
+    error_handler_null(worker->steal_order, NULL, "steal_order couldn't allocate memory", true);
+    worker->t_queue = t_queue;
+    pthread_mutex_init(&worker->mutex, NULL);
+    return worker;
+}
+
+void set_steal_order(Task_queue *t_queue) {
+    int amount = t_queue->thread_amount;
+    for (int i = 0; i < amount; i++) {
+        Worker *worker = t_queue->workers[i];
+        int order = 0;
+        //first the workers on the same node, then the ones on other nodes
+        for (int same_node = 1; same_node >= 0; same_node--) {
+            for (int j = 1; j < amount; j++) {
+                Worker *other = t_queue->workers[(i + j) % amount];
+                if ((other->node == worker->node) == same_node) {
+                    worker->steal_order[order++] = other->id;
+                }
+            }
+        }
+    }
+}
+
+void push_task(Worker *worker, Task *task) {
+    pthread_mutex_lock(&worker->mutex);
+    list_insert(list_first(worker->deque), task);
+    __atomic_add_fetch(&worker->t_queue->queue_length, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&worker->mutex);
+}
+
+void push_tasks(Worker *worker, List *tasks, int task_amount) {
+    pthread_mutex_lock(&worker->mutex);
+    list_splice(list_first(worker->deque), tasks);
+    __atomic_add_fetch(&worker->t_queue->queue_length, task_amount, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&worker->mutex);
+}
+
+/**
+ * Removes the task at pos from a deque, and returns a copy of it. The original is deallocated by the list.
+ * The deque's mutex has to be held, so the task stops being counted at the same time as it's removed.
+ */
+static Task *remove_task(Worker *worker, ListPos pos) {
+    Task *task = list_inspect(pos);
+    Task *copy_task = malloc(sizeof(Task));
+    error_handler_null(copy_task, NULL, "copy_task couldn't allocate memory", true);
+    *copy_task = *task;
+    list_remove(pos);
+    __atomic_sub_fetch(&worker->t_queue->queue_length, 1, __ATOMIC_SEQ_CST);
+    return copy_task;
+}
+
+Task *pop_task(Worker *worker) {
+    Task *task = NULL;
+    pthread_mutex_lock(&worker->mutex);
+    if (!list_is_empty(worker->deque)) {
+        task = remove_task(worker, list_first(worker->deque));
+    }
+    pthread_mutex_unlock(&worker->mutex);
+    return task;
+}
+
+Task *steal_task(Worker *worker) {
+    Task *task = NULL;
+    pthread_mutex_lock(&worker->mutex);
+    if (!list_is_empty(worker->deque)) {
+        task = remove_task(worker, list_prev(list_end(worker->deque)));
+    }
+    pthread_mutex_unlock(&worker->mutex);
+    return task;
+}
+
+void destroy_worker(Worker *worker) {
+    while (!list_is_empty(worker->deque)) {
+        kill_task(pop_task(worker));
+    }
+    pthread_mutex_destroy(&worker->mutex);
+    free(worker->steal_order);
+    free(worker->histogram);
+    if (worker->owners != NULL) {
+        destroy_owner_map(worker->owners);
+    }
+    if (worker->extensions != NULL) {
+        destroy_extension_map(worker->extensions);
+    }
+    free(worker->deque);
+    free(worker);
+}
+
 void kill_task(Task *task) {
     if (task != NULL) {
-        if (task->path != NULL) {
-            free(task->path);
-        }
         free(task);
     }
 }
\ No newline at end of file
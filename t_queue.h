@@ -6,6 +6,10 @@
  * Note, this is a queue that has the purpose of being a task queue for a thread pool to read
  * tasks from.
  *
+ * Apart from the shared queue, every thread in the pool owns a worker with a deque of tasks. The owner
+ * pushes and pops tasks at the top of its deque (depth first), while other threads steal from the bottom
+ * of it, where the shallowest tasks are.
+ *
  * @author  Ludwig Fallström
  * @since   2021-11-16
  * @version 1.0
@@ -16,19 +20,49 @@
 #ifndef T_QUEUE_H
 #define T_QUEUE_H
 
-#define CHAR_BUF 4096
+#define AUTO_THREAD_START 2
+#define AUTO_THREAD_MAX 128
 
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <unistd.h>
+#include <time.h>
+#include <signal.h>
 #include "string.h"
 
 #include "list.h"
+#include "dir_node.h"
+#include "libmdu.h"
+#include "inode_set.h"
+#include "owner_map.h"
+#include "extension_map.h"
 #include "error_handler.h"
 
 
+struct worker;
+struct checkpoint;
+
+/**
+ * @brief                  A struct which is the structure for a root that is inside of another root, or the same
+ *                         as an earlier one, and is only calculated once.
+ *
+ * @elem dev               The device number of the root.
+ * @elem ino               The inode number of the root.
+ * @elem index             The index of the root.
+ * @elem done              True when the directory of the root has been completed, in it's own scan or in the scan
+ *                         of another root.
+ * @elem result            The result of the root, when it's done.
+ */
+typedef struct shared_root {
+    dev_t dev;
+    ino_t ino;
+    int index;
+    bool done;
+    Mdu_result result;
+} Shared_root;
+
 /**
  * @brief                  A struct which is the structure of the task queue.
  *
@@ -36,54 +70,176 @@
  *                         Also has settings for the task queue as well as a thread pool.
  *
  * @elem task_q            A list which the queue is built upon.
+ * @elem workers           The workers of the thread pool, one for each thread.
  * @elem mutex             A variable for holding a mutex lock.
  * @elem cond              A condition variable.
- * @elem thread_amount     A amount of threads specified by the user.
- * @elem block_size        A variable for storing a block size.
+ * @elem park_cond         A condition variable that parked threads wait on.
+ * @elem fd_cond           A condition variable that the threads waiting for file descriptors wait on.
+ * @elem thread_amount     A amount of threads specified by the user. The upper limit in auto mode.
+ * @elem thread_limit      Amount of threads that are allowed to take tasks, the rest is parked.
+ * @elem queue_length      Amount of tasks currently in the queue and in the workers deques. Changed with atomic
+ *                         operations, in the same critical section that adds or removes a task, so a task that
+ *                         is counted can always be taken.
+ * @elem entries           Amount of directory entries that has been processed.
+ * @elem carried_fds       Amount of tasks waiting with an opened directory, which limits how many more are
+ *                         opened by the directory that found them.
+ * @elem carried_fd_max    The most tasks that waits with an opened directory at once.
+ * @elem totals            The totals of the root, stored when it's complete.
+ * @elem start_time        The time when the calculation of the current root started.
+ * @elem deadline          The time when directories stop being read, if has_deadline is true.
+ * @elem has_deadline      True if the scan has a deadline.
+ * @elem cancel            The flag that cancels the scan when it's non-zero. NULL if it can't be cancelled.
+ * @elem checkpoint        The checkpoints that the scan is written to. NULL if no checkpoints are written.
+ * @elem pausing           True while the threads are paused for a checkpoint. No task is taken until the
+ *                         running ones are done and the checkpoint has been written.
+ * @elem duration          Seconds that the calculation of the root took, stored when it's complete.
+ * @elem dir_callback      Called when a directory is complete. NULL if not wanted.
+ * @elem file_callback     Called for every file. NULL if not wanted.
+ * @elem callback_data     A pointer given to the callbacks.
  * @elem t_running         Amount of threads currently running.
+ * @elem tasks_done        Amount of tasks that have been done, which closes the directories they had opened.
+ * @elem fd_waiting        Amount of running threads that wait for file descriptors to be closed.
+ * @elem auto_threads      True if the thread amount is adjusted while running (-j auto).
+ * @elem follow            The symbolic links that are followed.
+ * @elem visited           The directories that have been reached in the file tree of the current root, when
+ *                         every link is followed. NULL otherwise.
+ * @elem shared_roots      The roots that are inside of another root, or the same as an earlier one.
+ * @elem shared_amount     Amount of shared roots.
+ * @elem sort_inodes       True if the entries of a directory are stat'ed in the order of their inode numbers.
+ * @elem sample_rate       The probability that a directory is read when estimating. 1 for a full scan.
+ * @elem age               The time that the ages of the entries are counted from. MDU_AGE_NONE if ages aren't
+ *                         collected.
+ * @elem age_start         The time that the ages are counted up to, the start of the scan.
+ * @elem age_boundaries    The ages in seconds that separate the age buckets.
+ * @elem age_boundary_amount Amount of age boundaries.
+ * @elem owner_key         The owner that files and blocks are counted for. MDU_OWNER_NONE if owners aren't counted.
  * @elem permission        A boolean to indicate if there was no permission to access a path.
  * @elem shutdown          A boolean that indicates for the threadpool when it's time to stop.
  *
  */
 typedef struct task_queue {
     List *task_q;
+    struct worker **workers;
     pthread_mutex_t mutex;
     pthread_cond_t cond;
+    pthread_cond_t park_cond;
+    pthread_cond_t fd_cond;
     int thread_amount;
-    blkcnt_t block_size;
+    int thread_limit;
+    long queue_length;
+    long entries;
+    int carried_fds;
+    int carried_fd_max;
+    Mdu_totals totals;
+    struct timespec start_time;
+    struct timespec deadline;
+    bool has_deadline;
+    volatile sig_atomic_t *cancel;
+    struct checkpoint *checkpoint;
+    bool pausing;
+    double duration;
+    Mdu_callback dir_callback;
+    Mdu_callback file_callback;
+    void *callback_data;
     int t_running;
+    long tasks_done;
+    int fd_waiting;
+    bool auto_threads;
+    Mdu_follow follow;
+    Inode_set *visited;
+    Shared_root *shared_roots;
+    int shared_amount;
+    bool sort_inodes;
+    double sample_rate;
+    Mdu_age age;
+    time_t age_start;
+    double age_boundaries[MDU_AGE_BUCKETS - 1];
+    int age_boundary_amount;
+    Mdu_owner_key owner_key;
     bool permission;
     bool shutdown;
 } Task_queue;
 
+/**
+ * @brief                 A struct which is the structure for a worker in the thread pool.
+ *
+ *                        The deque is only locked by its own mutex, so that the owner and the threads stealing
+ *                        from it doesn't have to take the lock of the task queue.
+ *
+ * @elem deque            A list which the deque is built upon. The first position is the top.
+ * @elem mutex            A variable for holding a mutex lock for the deque.
+ * @elem id               The id of the worker, also the index in the task queues workers.
+ * @elem cpu              The CPU that the worker's thread is pinned to. -1 if it isn't pinned.
+ * @elem node             The NUMA node of the CPU.
+ * @elem steal_order      The ids of the other workers, in the order they are stolen from. Workers on the
+ *                        same node comes first.
+ * @elem dir_amount       Amount of directory nodes that the worker has created, used for giving them ids.
+ * @elem random_state     The state of the random numbers that the worker samples directories with.
+ * @elem histogram        The histogram of the sizes of the files that the worker has found in the current root.
+ *                        NULL if no histograms are collected.
+ * @elem owners           The files and blocks of the owners that the worker has found in the current root. NULL
+ *                        if no owners are counted.
+ * @elem extensions       The files and blocks of the file types and extensions that the worker has found in the
+ *                        current root. NULL if no extensions are counted.
+ * @elem t_queue          The task queue that the worker belongs to.
+ */
+typedef struct worker {
+    List *deque;
+    pthread_mutex_t mutex;
+    int id;
+    int cpu;
+    int node;
+    int *steal_order;
+    long dir_amount;
+    unsigned long long random_state;
+    Mdu_histogram *histogram;
+    Owner_map *owners;
+    Extension_map *extensions;
+    Task_queue *t_queue;
+} Worker;
+
 /**
  * @brief                 A struct which is the structure for a task
  *
  * @elem task_pointer     A function pointer, which points to a function that the threadpool will execute.
+ * @elem node             The node of the directory that the task will calculate the size of. NULL for
+ *                        a kill task.
+ * @elem entries          Amount of directory entries the task has processed.
+ * @elem inline_depth     How many directories deep the task currently is in directories processed inline.
+ * @elem carried_fd       True if the directory was opened by the task that found it, and is counted in
+ *                        carried_fds.
  */
 typedef struct task {
-    blkcnt_t (*task_pointer)(struct task *, Task_queue *);
-    char *path;
+    blkcnt_t (*task_pointer)(struct task *, Worker *);
+    Dir_node *node;
+    long entries;
+    int inline_depth;
+    bool carried_fd;
 } Task;
 
 
 /**
  * @brief                Creates a task queue. Allocates memory and initializes it's values.
  *
+ *                       If auto_threads is true, thread_amount is the upper limit of threads, and the
+ *                       thread pool starts with AUTO_THREAD_START threads taking tasks.
+ *                       One worker is created for each of the thread_amount threads.
+ *
  * @param thread_amount  The thread amount that will be stored in the queue.
+ * @param auto_threads   True if the thread amount should be adjusted while running.
  * @return               Returns a task queue that has been dynamically allocated.
  */
-Task_queue *create_task_queue(int thread_amount);
+Task_queue *create_task_queue(int thread_amount, bool auto_threads);
 
 
 /**
  * @brief                Creates a task, and allocates memory for it, also takes it's parameters as values.
  *
- * @param path           A path that will be stored in the task.
+ * @param node           A directory node that will be stored in the task.
  * @param task_pointer   A function pointer to a function that the thread pool will execute.
  * @return               Returns a task that has been dynamically allocated.
  */
-Task *create_task(char *path, void (*task_pointer)(struct task *, Task_queue *));
+Task *create_task(Dir_node *node, void (*task_pointer)(struct task *, Worker *));
 
 
 /**
@@ -120,7 +276,90 @@ bool queue_is_empty(Task_queue *queue);
 
 
 /**
- * @brief                Deallocates the task's internal values, and the task itself.
+ * @brief                Gives the amount of tasks in the queue and in the deques of the workers.
+ *
+ * @param queue          The queue.
+ * @return               Amount of tasks that can be taken.
+ */
+long waiting_tasks(Task_queue *queue);
+
+
+/**
+ * @brief                Creates a worker, and allocates memory for it.
+ *
+ * @param t_queue        The task queue that the worker belongs to.
+ * @param id             The id of the worker.
+ * @return               Returns a worker that has been dynamically allocated.
+ */
+Worker *create_worker(Task_queue *t_queue, int id);
+
+
+/**
+ * @brief                Sets the steal order of every worker in the task queue.
+ *
+ *                       Each worker steals from the workers on the same node first, and then from the rest.
+ *                       Within a node the order starts at the next worker, so that the workers doesn't
+ *                       all try to steal from the same one.
+ *
+ * @param t_queue        The task queue with the workers.
+ */
+void set_steal_order(Task_queue *t_queue);
+
+
+/**
+ * @brief                Adds a task at the top of the worker's deque.
+ *
+ * @param worker         The worker that owns the deque.
+ * @param task           The task that will be added.
+ */
+void push_task(Worker *worker, Task *task);
+
+
+/**
+ * @brief                Adds a list of tasks at the top of the worker's deque, in one operation.
+ *
+ *                       The first task in the list ends up at the top. The list is left empty.
+ *
+ * @param worker         The worker that owns the deque.
+ * @param tasks          A list of tasks that will be added.
+ * @param task_amount    Amount of tasks in the list.
+ */
+void push_tasks(Worker *worker, List *tasks, int task_amount);
+
+
+/**
+ * @brief                Removes the task at the top of the worker's deque, the most recently pushed one.
+ *
+ *                       NOTE! It's the user's responsibility to deallocate the returned value.
+ *
+ * @param worker         The worker that owns the deque.
+ * @return               Returns a copy of the task on newly allocated memory. NULL if the deque is empty.
+ */
+Task *pop_task(Worker *worker);
+
+
+/**
+ * @brief                Removes the task at the bottom of the worker's deque, the oldest and shallowest one.
+ *
+ *                       NOTE! It's the user's responsibility to deallocate the returned value.
+ *
+ * @param worker         The worker that is stolen from.
+ * @return               Returns a copy of the task on newly allocated memory. NULL if the deque is empty.
+ */
+Task *steal_task(Worker *worker);
+
+
+/**
+ * @brief                Deallocates the worker and the tasks in it's deque.
+ *
+ * @param worker         The worker that will be deallocated.
+ */
+void destroy_worker(Worker *worker);
+
+
+/**
+ * @brief                Deallocates the task. The directory node is not deallocated, since it lives
+ *                       until the directory is complete.
  *
  * @param task           The task that will be deallocated.
  */
@@ -6,8 +6,6 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-#define MAX_PATH 4096
-
 void eksde() {
     printf("hej hopp\n");
 }
@@ -15,20 +13,17 @@ void eksde() {
 int main(void) {
 
     //test creation
-    Task_queue *queue = create_task_queue(10);
+    Task_queue *queue = create_task_queue(10, false);
 
     for (int i = 0; i < 10; i++) {
-        char *temp_path = malloc(MAX_PATH * sizeof(char));
-        strcpy(temp_path, "eksde");
-        Task *task = create_task(temp_path, (void *)eksde);
+        Task *task = create_task(create_dir_node(NULL, "eksde", i + 1), (void *)eksde);
         enqueue(queue, task);
     }
     Task *outside_task = dequeue(queue);
-    printf("%s\n", outside_task->path);
+    printf("%s\n", outside_task->node->name);
+    destroy_dir_node(outside_task->node);
 
-    char *temp_path = malloc(MAX_PATH * sizeof(char));
-    strcpy(temp_path, "eksde");
-    Task *task = create_task(temp_path, (void *)eksde);
+    Task *task = create_task(create_dir_node(NULL, "eksde", 11), (void *)eksde);
     enqueue(queue, task);
 
     kill_task(outside_task);